@@ -0,0 +1,97 @@
+/*
+ * FTP Client - Asynchronous Transfers Example
+ *
+ * Demonstrates running many transfers from a single thread:
+ * - Creating an asynchronous engine from a configured client
+ * - Starting uploads, downloads and listings without blocking
+ * - Driving all transfers with completion callbacks
+ */
+
+#define FTP_CLIENT_IMPLEMENTATION
+#include "../ftpclient.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int completed = 0;
+static int failed = 0;
+
+// Called once for every finished request
+static void on_complete(void *user_data, ftp_async_request_t *request, int result)
+{
+    const char *name = (const char *)user_data;
+
+    if (result == FTP_OK) {
+        completed++;
+        printf("Done: %s\n", name);
+    } else {
+        failed++;
+        fprintf(stderr, "Failed: %s (%s)\n", name, ftp_async_request_get_error(request));
+    }
+}
+
+// Called when the directory listing has arrived
+static void on_listing(void *user_data, ftp_async_request_t *request, int result)
+{
+    if (result == FTP_OK) {
+        printf("Directory contents:\n%s\n", ftp_async_request_get_data(request, NULL));
+    }
+    on_complete(user_data, request, result);
+}
+
+int main(void)
+{
+    static const char *files[] = { "report1.csv", "report2.csv", "report3.csv", "report4.csv" };
+    char remote_path[256];
+
+    // Initialize
+    if (ftp_global_init() != FTP_OK) {
+        fprintf(stderr, "Failed to initialize FTP library\n");
+        return 1;
+    }
+
+    ftp_client_t *client = ftp_client_create();
+    if (!client) {
+        fprintf(stderr, "Failed to create FTP client\n");
+        ftp_global_cleanup();
+        return 1;
+    }
+
+    // Configure connection
+    ftp_client_set_host(client, "ftp.example.com", 21);
+    ftp_client_set_credentials(client, "username", "password");
+
+    // Create the engine with at most 8 simultaneous connections
+    ftp_async_t *async = ftp_async_create(client, 8);
+    if (!async) {
+        fprintf(stderr, "Failed to create asynchronous engine\n");
+        ftp_client_destroy(client);
+        ftp_global_cleanup();
+        return 1;
+    }
+
+    // Queue all uploads; none of these calls block
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(remote_path, sizeof(remote_path), "/upload/%s", files[i]);
+        if (!ftp_async_upload(async, files[i], remote_path, on_complete, (void *)files[i])) {
+            fprintf(stderr, "Could not start upload of %s\n", files[i]);
+        }
+    }
+
+    // Downloads and listings run concurrently with the uploads
+    ftp_async_download(async, "/download/test.txt", "downloaded_file.txt", on_complete, "test.txt");
+    ftp_async_list(async, "/", on_listing, "/");
+
+    // Drive everything from this thread; poll can be interleaved with other work
+    while (ftp_async_poll(async, 100) > 0) {
+        // Other work could happen here
+    }
+
+    printf("\n%d transfers completed, %d failed\n", completed, failed);
+
+    // Cleanup
+    ftp_async_destroy(async);
+    ftp_client_destroy(client);
+    ftp_global_cleanup();
+
+    return failed == 0 ? 0 : 1;
+}
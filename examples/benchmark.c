@@ -0,0 +1,140 @@
+/*
+ * FTP Client - Buffer Size Benchmark
+ *
+ * Measures upload and download throughput with different buffer settings:
+ * - libcurl receive and upload buffers
+ * - stdio buffers for the local files
+ *
+ * Usage: benchmark [host] [port] [username] [password] [size_mb]
+ * Run it against a server on the same host or a fast LAN; on slow links the
+ * network, not the buffers, limits throughput.
+ */
+
+#define FTP_CLIENT_IMPLEMENTATION
+#include "../ftpclient.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+typedef struct {
+    const char *name;
+    long receive_buffer;
+    long upload_buffer;
+    size_t file_buffer;
+} buffer_config_t;
+
+// Wall clock time in seconds
+static double now_seconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+// Write a test file of the given size
+static int create_test_file(const char *path, long size_mb)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return 0;
+    }
+
+    static char block[1024 * 1024];
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] = (char)(i * 31);
+    }
+    for (long i = 0; i < size_mb; i++) {
+        if (fwrite(block, 1, sizeof(block), fp) != sizeof(block)) {
+            fclose(fp);
+            return 0;
+        }
+    }
+    return fclose(fp) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? atoi(argv[2]) : 21;
+    const char *username = argc > 3 ? argv[3] : "anonymous";
+    const char *password = argc > 4 ? argv[4] : "user@example.com";
+    long size_mb = argc > 5 ? atol(argv[5]) : 256;
+
+    static const buffer_config_t configs[] = {
+        { "defaults", 0, 0, 0 },
+        { "256 KB", 256 * 1024, 256 * 1024, 256 * 1024 },
+        { "1 MB", 1024 * 1024, 2 * 1024 * 1024, 1024 * 1024 },
+        { "4 MB", 4 * 1024 * 1024, 2 * 1024 * 1024, 4 * 1024 * 1024 },
+    };
+    const double megabytes = (double)size_mb;
+
+    if (size_mb <= 0 || !create_test_file("bench.bin", size_mb)) {
+        fprintf(stderr, "Failed to create test file\n");
+        return 1;
+    }
+
+    // Initialize
+    if (ftp_global_init() != FTP_OK) {
+        fprintf(stderr, "Failed to initialize FTP library\n");
+        return 1;
+    }
+
+    ftp_client_t *client = ftp_client_create();
+    if (!client) {
+        fprintf(stderr, "Failed to create FTP client\n");
+        ftp_global_cleanup();
+        return 1;
+    }
+
+    ftp_client_set_host(client, host, port);
+    ftp_client_set_credentials(client, username, password);
+    ftp_client_set_session_reuse(client, 1);
+
+    printf("%ld MB file, %s:%d\n\n", size_mb, host, port);
+    printf("%-10s %14s %14s\n", "buffers", "upload MB/s", "download MB/s");
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]) && !failed; i++) {
+        const buffer_config_t *config = &configs[i];
+        ftp_client_set_buffer_sizes(client, config->receive_buffer, config->upload_buffer, config->file_buffer);
+
+        double start = now_seconds();
+        if (ftp_client_upload(client, "bench.bin", "/bench.bin") != FTP_OK) {
+            fprintf(stderr, "Upload failed: %s\n", ftp_client_get_error(client));
+            failed = 1;
+            break;
+        }
+        double upload_seconds = now_seconds() - start;
+
+        start = now_seconds();
+        if (ftp_client_download(client, "/bench.bin", "bench_copy.bin") != FTP_OK) {
+            fprintf(stderr, "Download failed: %s\n", ftp_client_get_error(client));
+            failed = 1;
+            break;
+        }
+        double download_seconds = now_seconds() - start;
+
+        printf("%-10s %14.1f %14.1f\n", config->name, megabytes / upload_seconds, megabytes / download_seconds);
+    }
+
+    // Cleanup
+    ftp_client_delete(client, "/bench.bin");
+    remove("bench.bin");
+    remove("bench_copy.bin");
+    ftp_client_destroy(client);
+    ftp_global_cleanup();
+
+    return failed;
+}
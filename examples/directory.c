@@ -4,6 +4,7 @@
  * Demonstrates directory management operations:
  * - Creating directories
  * - Listing directory contents
+ * - Walking a directory tree recursively
  * - Renaming/moving files
  * - Deleting files and directories
  */
@@ -13,6 +14,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+// Called for every entry found by the recursive walk
+static int print_entry(void *user_data, const char *dir_path, const ftp_entry_t *entry, int depth)
+{
+    (void)user_data;
+    printf("%*s%s/%s%s\n", depth * 2, "", dir_path, entry->name, entry->type == FTP_ENTRY_DIR ? "/" : "");
+    return 0;  // Continue walking
+}
+
 int main(void)
 {
     int result;
@@ -63,6 +72,17 @@ int main(void)
         free(listing);
     }
     
+    // Walk the whole tree, listing up to 4 directories at a time
+    printf("\nWalking /pub recursively...\n");
+    ftp_walk_options_t walk_options;
+    ftp_walk_init_options(&walk_options);
+    walk_options.workers = 4;
+    walk_options.max_depth = 3;
+    result = ftp_walk(client, "/pub", print_entry, NULL, &walk_options);
+    if (result != FTP_OK) {
+        fprintf(stderr, "Walk failed: %s\n", ftp_client_get_error(client));
+    }
+    
     // Upload a test file to the new directory
     printf("Uploading test file...\n");
     result = ftp_client_upload(client, "test.txt", "/test_folder/test.txt");
@@ -25,19 +25,48 @@
  *   - Active and passive modes
  *   - Comprehensive error handling
  *   - Custom FTP command execution
+ *   - Persistent logged-in sessions with reuse statistics
+ *   - Thread-safe connection pool of logged-in sessions
+ *   - Non-blocking asynchronous transfers driven from a single thread
+ *   - Parallel segmented downloads of large files
+ *   - Downloads into memory, presized from the announced file size
+ *   - Streaming downloads into a user sink with pause and abort
+ *   - Multi-file transfer queue drained by worker threads
+ *   - Resumable downloads through .part files
+ *   - Disk space reservation for downloads
+ *   - Atomic download publishing with an optional fsync policy
+ *   - Resumable uploads that append only the missing tail
+ *   - Memory-mapped uploads that bypass stdio buffering
+ *   - Inline CRC32C, XXH64 and SHA-256 checksums of transferred data
+ *   - Optional MODE Z (deflate) compressed transfers
+ *   - Bandwidth limits per client and shared token buckets across clients
+ *   - Per-operation timing breakdown and transfer statistics
+ *   - Configurable network and local file buffer sizes
+ *   - Uploads from memory buffers and scatter/gather segment lists
+ *   - Batched command execution with per-command replies
+ *   - Structured directory listings from MLSD or parsed Unix/DOS LIST output
+ *   - Streaming directory listings with bounded memory
+ *   - Parallel recursive directory walks
+ *   - Local/remote directory sync that transfers only changes
+ *   - Shared metadata cache with TTL and write-through invalidation
  *
  * THREAD SAFETY:
  *   The ftp_client_t handle is NOT thread-safe. A single client handle should not
  *   be used from multiple threads simultaneously without external synchronization.
  *   However, it is safe to create and use separate ftp_client_t handles in different
- *   threads concurrently.
+ *   threads concurrently. Use ftp_client_duplicate() to create per-thread handles, or
+ *   an ftp_pool_t, whose checkout/checkin functions are thread-safe.
  *
  * DEPENDENCIES:
  *   libcurl (7.20.0 or later)
+ *   pthreads (POSIX) or the Win32 threading API
  *
  * OPTIONAL DEFINES:
  *   #define FTP_MAX_URL_LENGTH 4096     // Default: 2048
  *   #define FTP_BUFFER_SIZE 16384       // Default: 8192
+ *   #define FTP_MIN_SEGMENT_SIZE 4194304 // Default: 1048576 (parallel download segment floor)
+ *   #define FTP_REPLY_TEXT_SIZE 1024    // Default: 256 (reply text kept per batched command)
+ *   #define FTP_CLIENT_ENABLE_ZLIB      // MODE Z compressed transfers (link with -lz)
  *
  * LICENSE:
  *   See end of file for license information.
@@ -67,6 +96,14 @@ extern "C"
 
 #ifndef FTP_BUFFER_SIZE
 #define FTP_BUFFER_SIZE 8192
+#endif
+
+#ifndef FTP_MIN_SEGMENT_SIZE
+#define FTP_MIN_SEGMENT_SIZE 1048576
+#endif
+
+#ifndef FTP_REPLY_TEXT_SIZE
+#define FTP_REPLY_TEXT_SIZE 256
 #endif
 
 	/* Error codes */
@@ -113,6 +150,59 @@ extern "C"
 		size_t capacity;
 	} ftp_memory_buffer_t;
 
+	/* Return values of a download sink callback */
+	typedef enum
+	{
+		FTP_SINK_CONTINUE = 0, /* All data consumed */
+		FTP_SINK_PAUSE = 1,	   /* Nothing consumed; offer the same data again later */
+		FTP_SINK_ABORT = 2	   /* Stop the download */
+	} ftp_sink_result_t;
+
+	/* When downloaded data is forced to stable storage */
+	typedef enum
+	{
+		FTP_FSYNC_NONE = 0,			/* Leave it to the operating system */
+		FTP_FSYNC_FILE = 1,			/* Flush the file before it is published */
+		FTP_FSYNC_FILE_AND_DIR = 2	/* Also flush the directory entry after publishing */
+	} ftp_fsync_policy_t;
+
+	/* Checksums computed while data passes through a transfer (bit flags) */
+	typedef enum
+	{
+		FTP_CHECKSUM_NONE = 0,
+		FTP_CHECKSUM_CRC32C = 1,
+		FTP_CHECKSUM_XXH64 = 2,
+		FTP_CHECKSUM_SHA256 = 4
+	} ftp_checksum_type_t;
+
+	/* Digests of the data moved by the last upload or download */
+	typedef struct
+	{
+		unsigned int types; /* ftp_checksum_type_t flags that were computed */
+		int64_t bytes;		/* Bytes hashed */
+		uint32_t crc32c;
+		uint64_t xxh64; /* Seed 0 */
+		unsigned char sha256[32];
+	} ftp_checksums_t;
+
+	/* Compression summary of the last upload or download */
+	typedef struct
+	{
+		int compressed;		/* 1 if the transfer used MODE Z */
+		int64_t raw_bytes;	/* Uncompressed bytes read from or delivered to the caller */
+		int64_t wire_bytes; /* Compressed bytes on the data connection */
+	} ftp_compression_stats_t;
+
+	/* Download sink callback function type; returns an ftp_sink_result_t */
+	typedef int (*ftp_sink_callback_t)(void *user_data, const void *data, size_t size);
+
+	/* One segment of a scatter/gather upload (same fields as POSIX struct iovec) */
+	typedef struct
+	{
+		const void *iov_base;
+		size_t iov_len;
+	} ftp_iovec_t;
+
 	/* FTP client configuration */
 	typedef struct
 	{
@@ -126,15 +216,251 @@ extern "C"
 		long timeout;
 		long connect_timeout;
 		int verbose;
+		int keep_session;
+		int resume_downloads;
+		int mmap_uploads;
+		int preallocate_downloads;
+		int atomic_downloads;
+		ftp_fsync_policy_t fsync_policy;
+		long receive_buffer_size;
+		long upload_buffer_size;
+		size_t file_buffer_size;
+		unsigned int checksum_types;
+		int compression_level;
+		int64_t max_send_speed;
+		int64_t max_receive_speed;
 		ftp_progress_callback_t progress_callback;
 		void *progress_user_data;
 	} ftp_config_t;
 
+	/* Failure handling for batched commands */
+	typedef enum
+	{
+		FTP_BATCH_STOP_ON_ERROR = 0,
+		FTP_BATCH_CONTINUE_ON_ERROR = 1
+	} ftp_batch_policy_t;
+
+	/* Reply to one command of a batch; code is 0 if the command was not sent */
+	typedef struct
+	{
+		int code;
+		char text[FTP_REPLY_TEXT_SIZE];
+	} ftp_command_result_t;
+
+	/* Directory entry type */
+	typedef enum
+	{
+		FTP_ENTRY_UNKNOWN = 0,
+		FTP_ENTRY_FILE = 1,
+		FTP_ENTRY_DIR = 2,
+		FTP_ENTRY_LINK = 3
+	} ftp_entry_type_t;
+
+	/* Parsed directory entry; size, modify_time and perms are -1 when unknown */
+	typedef struct
+	{
+		const char *name;
+		ftp_entry_type_t type;
+		int64_t size;
+		int64_t modify_time; /* Seconds since the Unix epoch, UTC */
+		int perms;			 /* Unix permission bits */
+	} ftp_entry_t;
+
+	/* Directory listing; all entry names live in the single arena block */
+	typedef struct
+	{
+		ftp_entry_t *entries;
+		size_t count;
+		char *arena;
+	} ftp_entry_list_t;
+
+	/* Streaming listing callback; return non-zero to stop the listing */
+	typedef int (*ftp_entry_callback_t)(void *user_data, const ftp_entry_t *entry);
+
+	/* Shared cache of remote file sizes, times and listings (opaque) */
+	typedef struct ftp_cache ftp_cache_t;
+
+	/* Thread-safe token bucket limiting the bandwidth of the clients attached to it (opaque) */
+	typedef struct ftp_rate_limiter ftp_rate_limiter_t;
+
+	/* Metadata cache statistics */
+	typedef struct
+	{
+		size_t entries;
+		unsigned long hits;
+		unsigned long misses;
+		unsigned long invalidations;
+		unsigned long evictions;
+	} ftp_cache_stats_t;
+
+	/* Session reuse statistics */
+	typedef struct
+	{
+		unsigned long operations;
+		unsigned long connections_opened;
+		unsigned long connections_reused;
+	} ftp_session_stats_t;
+
+	/* Timing breakdown of the last operation; times are seconds since it started */
+	typedef struct
+	{
+		int64_t bytes_uploaded;
+		int64_t bytes_downloaded;
+		double upload_speed;	   /* Average bytes per second */
+		double download_speed;	   /* Average bytes per second */
+		double namelookup_time;	   /* Name resolved */
+		double connect_time;	   /* TCP connection established */
+		double appconnect_time;	   /* TLS handshake done (0 without TLS) */
+		double pretransfer_time;   /* Login and commands done, transfer about to start */
+		double starttransfer_time; /* First byte received */
+		double total_time;
+		long connections_opened; /* New control and data connections; 1 if only the data connection was new */
+	} ftp_transfer_stats_t;
+
+	/* Connection pool of logged-in clients (opaque) */
+	typedef struct ftp_pool ftp_pool_t;
+
+	/* Connection pool options */
+	typedef struct
+	{
+		size_t min_sessions;
+		size_t max_sessions;
+		long idle_timeout;
+		long checkout_timeout;
+	} ftp_pool_options_t;
+
+	/* Connection pool statistics */
+	typedef struct
+	{
+		size_t total;
+		size_t idle;
+		size_t in_use;
+		unsigned long created;
+		unsigned long evicted;
+		unsigned long checkouts;
+		unsigned long waits;
+	} ftp_pool_stats_t;
+
+	/* Multi-file transfer queue (opaque) */
+	typedef struct ftp_transfer_queue ftp_transfer_queue_t;
+
+	/* Transfer queue job type */
+	typedef enum
+	{
+		FTP_JOB_UPLOAD = 0,
+		FTP_JOB_DOWNLOAD = 1
+	} ftp_job_type_t;
+
+	/* Transfer queue job state */
+	typedef enum
+	{
+		FTP_JOB_PENDING = 0,
+		FTP_JOB_RUNNING = 1,
+		FTP_JOB_DONE = 2,
+		FTP_JOB_FAILED = 3
+	} ftp_job_state_t;
+
+	/* Transfer queue job status */
+	typedef struct
+	{
+		ftp_job_state_t state;
+		int result;
+		int64_t bytes;
+		double seconds;
+		char error[512];
+	} ftp_job_status_t;
+
+	/* Transfer queue aggregate statistics */
+	typedef struct
+	{
+		size_t submitted;
+		size_t pending;
+		size_t running;
+		size_t completed;
+		size_t failed;
+		int64_t bytes;
+		double elapsed;
+		double bytes_per_second;
+	} ftp_queue_stats_t;
+
+	/* Asynchronous transfer engine and request handles (opaque) */
+	typedef struct ftp_async ftp_async_t;
+	typedef struct ftp_async_request ftp_async_request_t;
+
+	/* Asynchronous completion callback function type */
+	typedef void (*ftp_async_callback_t)(void *user_data, ftp_async_request_t *request, int result);
+
+	/* Recursive walk visitor; dir_path is the directory containing entry. Return non-zero to stop. */
+	typedef int (*ftp_walk_visitor_t)(void *user_data, const char *dir_path, const ftp_entry_t *entry, int depth);
+
+	/* Recursive walk options */
+	typedef struct
+	{
+		int workers;
+		int max_depth;
+		ftp_pool_t *pool;
+	} ftp_walk_options_t;
+
+	/* Directory sync direction */
+	typedef enum
+	{
+		FTP_SYNC_UPLOAD = 0,
+		FTP_SYNC_DOWNLOAD = 1
+	} ftp_sync_direction_t;
+
+	/* Directory sync action */
+	typedef enum
+	{
+		FTP_SYNC_ACTION_MKDIR = 0,
+		FTP_SYNC_ACTION_UPLOAD = 1,
+		FTP_SYNC_ACTION_DOWNLOAD = 2,
+		FTP_SYNC_ACTION_DELETE = 3,
+		FTP_SYNC_ACTION_RMDIR = 4
+	} ftp_sync_action_t;
+
+	/* Sync report callback; path is relative to the synced directories, result is FTP_OK in a dry run */
+	typedef void (*ftp_sync_callback_t)(void *user_data, ftp_sync_action_t action, const char *path, int64_t bytes,
+										int result);
+
+	/* Directory sync options */
+	typedef struct
+	{
+		int workers;
+		int dry_run;
+		int delete_extra;
+		int compare_mtime;
+		long mtime_tolerance;
+		ftp_sync_callback_t callback;
+		void *user_data;
+	} ftp_sync_options_t;
+
+	/* Directory sync summary */
+	typedef struct
+	{
+		size_t files_compared;
+		size_t unchanged;
+		size_t transfers;
+		size_t deletions;
+		size_t directories_created;
+		size_t conflicts;
+		size_t failed;
+		int64_t bytes;
+	} ftp_sync_stats_t;
+
 	/* FTP client handle */
 	typedef struct
 	{
 		CURL *curl;
 		ftp_config_t config;
+		int options_applied;
+		unsigned int server_features;
+		ftp_cache_t *cache;
+		ftp_rate_limiter_t *rate_limiter;
+		ftp_session_stats_t session_stats;
+		ftp_transfer_stats_t transfer_stats;
+		struct ftp_checksum_state *checksum_state;
+		struct ftp_compression_state *compression_state;
+		struct ftp_throttle_state *throttle_state;
 		char last_error[512];
 	} ftp_client_t;
 
@@ -393,1239 +719,9346 @@ extern "C"
 	void ftp_client_set_progress_callback(ftp_client_t *client, ftp_progress_callback_t callback, void *user_data);
 
 	/**
-	 * @brief Test connection to FTP server
+	 * @brief Enable or disable resumable downloads
 	 *
-	 * Attempts to connect to the FTP server and authenticate using the configured
-	 * credentials. This verifies that the server is reachable and credentials are valid.
+	 * In resume mode ftp_client_download() writes to "<local_path>.part" instead of
+	 * the final path. If a partial file already exists, the download continues from
+	 * its current size using REST. The partial file is renamed to local_path only
+	 * after the download completes. It is kept on failure so that retrying the same
+	 * call continues where the previous attempt stopped.
 	 *
 	 * @param client Pointer to the FTP client handle
+	 * @param enable 1 to enable resume mode, 0 to disable (default)
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if client is NULL or host not set
-	 *         FTP_ERROR_AUTH (-3) if authentication fails
-	 *         FTP_ERROR_TIMEOUT (-10) if connection times out
-	 *         FTP_ERROR_CONNECTION (-2) for other connection errors
-	 *
-	 * @note This function executes a NOOP command to verify the connection.
-	 *       Use ftp_client_get_error() to retrieve detailed error messages.
+	 * @note The server must support REST. If the partial file is larger than the
+	 *       remote file (the remote file changed), the download restarts from zero.
 	 *
 	 * Example:
 	 * @code
-	 * int result = ftp_client_connect(client);
-	 * if (result != FTP_OK) {
-	 *     fprintf(stderr, "Connection failed: %s\n", ftp_client_get_error(client));
-	 *     return -1;
+	 * ftp_client_set_download_resume(client, 1);
+	 * while (ftp_client_download(client, "/dumps/db.tar", "db.tar") == FTP_ERROR_TRANSFER) {
+	 *     sleep(5);  // Retry; already downloaded bytes are kept
 	 * }
-	 * printf("Connected successfully!\n");
 	 * @endcode
 	 */
-	int ftp_client_connect(ftp_client_t *client);
+	void ftp_client_set_download_resume(ftp_client_t *client, int enable);
 
 	/**
-	 * @brief Upload a file to the FTP server
+	 * @brief Enable or disable memory-mapped uploads
 	 *
-	 * Transfers a file from the local filesystem to the FTP server.
+	 * In this mode ftp_client_upload() and ftp_client_upload_resume() map the
+	 * local file into memory with a sequential access hint and hand libcurl the
+	 * data straight from the mapping. This skips the stdio buffer and its
+	 * locking, which matters for multi-gigabyte files.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param local_path Path to the local file to upload
-	 * @param remote_path Destination path on the FTP server
+	 * @param enable 1 to enable memory-mapped uploads, 0 to disable (default)
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be opened
-	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 * @note Files that cannot be mapped (empty files, pipes, files larger than
+	 *       the address space) are uploaded through stdio as usual. The file must
+	 *       not be truncated while it is being uploaded; on POSIX systems reading
+	 *       past the new end of a mapping raises SIGBUS.
+	 */
+	void ftp_client_set_upload_mmap(ftp_client_t *client, int enable);
+
+	/**
+	 * @brief Enable or disable disk space reservation for downloads
 	 *
-	 * @note If progress callback is set, it will be called during the upload.
-	 *       Remote directories must exist before uploading to them.
+	 * When the server announces the file size, ftp_client_download() reserves
+	 * the whole file on disk before writing the first byte (posix_fallocate,
+	 * F_PREALLOCATE on macOS, the allocation size on Windows). The file is laid
+	 * out contiguously where the file system allows it, and a download that
+	 * cannot fit fails at once instead of midway.
 	 *
-	 * Example:
-	 * @code
-	 * int result = ftp_client_upload(client, "local_file.txt", "/upload/remote_file.txt");
-	 * if (result != FTP_OK) {
-	 *     fprintf(stderr, "Upload failed: %s\n", ftp_client_get_error(client));
-	 * }
-	 * @endcode
+	 * @param client Pointer to the FTP client handle
+	 * @param enable 1 to enable preallocation, 0 to disable (default)
+	 *
+	 * @note If the disk cannot hold the file the download fails with
+	 *       FTP_ERROR_FILE_IO before any data is written. File systems without
+	 *       preallocation support are written normally. The file is truncated
+	 *       to the bytes actually received when the transfer ends. Resumable
+	 *       downloads (ftp_client_set_download_resume()) are not preallocated,
+	 *       because the size of the partial file marks where to resume.
 	 */
-	int ftp_client_upload(ftp_client_t *client, const char *local_path, const char *remote_path);
+	void ftp_client_set_download_preallocate(ftp_client_t *client, int enable);
 
 	/**
-	 * @brief Download a file from the FTP server
+	 * @brief Enable or disable atomic downloads
 	 *
-	 * Transfers a file from the FTP server to the local filesystem.
+	 * In atomic mode ftp_client_download() writes to a hidden temporary file
+	 * (".<name>.XXXXXX") in the destination directory and renames it over
+	 * local_path only after the transfer completed. Other processes see either
+	 * the previous file or the complete new one, never a partial file. On
+	 * failure the temporary file is removed and local_path is left untouched.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path to the file on the FTP server
-	 * @param local_path Destination path on the local filesystem
+	 * @param enable 1 to enable atomic mode, 0 to disable (default)
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be created
-	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if remote file doesn't exist
-	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 * @note Resumable downloads (ftp_client_set_download_resume()) are already
+	 *       published atomically from their .part file. Combine with
+	 *       ftp_client_set_download_fsync() to survive power loss as well.
+	 */
+	void ftp_client_set_download_atomic(ftp_client_t *client, int enable);
+
+	/**
+	 * @brief Set when downloaded files are forced to stable storage
 	 *
-	 * @note If progress callback is set, it will be called during the download.
-	 *       Partial files are deleted if the download fails.
+	 * @param client Pointer to the FTP client handle
+	 * @param policy FTP_FSYNC_NONE (default), FTP_FSYNC_FILE to flush the file
+	 *               before it is renamed into place or closed, or
+	 *               FTP_FSYNC_FILE_AND_DIR to also flush the directory so the
+	 *               rename itself survives a crash
 	 *
-	 * Example:
-	 * @code
-	 * int result = ftp_client_download(client, "/download/file.txt", "local_file.txt");
-	 * if (result != FTP_OK) {
-	 *     fprintf(stderr, "Download failed: %s\n", ftp_client_get_error(client));
-	 * }
-	 * @endcode
+	 * @note A failed flush fails the download with FTP_ERROR_FILE_IO. Directory
+	 *       flushes are a no-op on Windows, where renames are journaled by NTFS.
 	 */
-	int ftp_client_download(ftp_client_t *client, const char *remote_path, const char *local_path);
+	void ftp_client_set_download_fsync(ftp_client_t *client, ftp_fsync_policy_t policy);
 
 	/**
-	 * @brief List directory contents on the FTP server
+	 * @brief Set network and local file buffer sizes
 	 *
-	 * Retrieves a listing of files and directories in the specified path.
+	 * Larger buffers mean fewer system calls and callback invocations per
+	 * byte, which raises throughput on fast links. Pass 0 for any size to keep
+	 * the default.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path to the directory on the FTP server
-	 * @param output Pointer to receive the allocated string with directory listing
-	 *
-	 * @return FTP_OK (0) on success, error code on failure
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if listing fails
+	 * @param receive_buffer libcurl receive buffer in bytes (CURLOPT_BUFFERSIZE,
+	 *                       default 16 KB, libcurl caps it at 10 MB)
+	 * @param upload_buffer libcurl upload buffer in bytes (CURLOPT_UPLOAD_BUFFERSIZE,
+	 *                      default 64 KB, libcurl caps it at 2 MB; needs libcurl 7.62.0)
+	 * @param file_buffer stdio buffer used for local files in bytes (default BUFSIZ)
 	 *
-	 * @note The caller is responsible for freeing the allocated output string.
-	 *       The format of the listing depends on the FTP server (typically Unix-style ls format).
+	 * @note Local files opened for a transfer also get a sequential access hint
+	 *       (posix_fadvise) where the platform supports it.
 	 *
 	 * Example:
 	 * @code
-	 * char *listing = NULL;
-	 * if (ftp_client_list_dir(client, "/", &listing) == FTP_OK) {
-	 *     printf("Directory contents:\n%s\n", listing);
-	 *     free(listing);
-	 * }
+	 * ftp_client_set_buffer_sizes(client, 512 * 1024, 1024 * 1024, 1024 * 1024);
 	 * @endcode
 	 */
-	int ftp_client_list_dir(ftp_client_t *client, const char *remote_path, char **output);
+	void ftp_client_set_buffer_sizes(ftp_client_t *client, long receive_buffer, long upload_buffer,
+									 size_t file_buffer);
 
 	/**
-	 * @brief Create a directory on the FTP server
+	 * @brief Select checksums computed inline during transfers
 	 *
-	 * Creates a new directory at the specified path on the FTP server.
+	 * The selected digests are updated from the data as it passes through the
+	 * upload read callback or download write callback, so verifying a transfer
+	 * needs no second pass over the file. Applies to ftp_client_upload() and
+	 * its memory/iovec variants, ftp_client_download() and the to_memory,
+	 * to_buffer and to_callback downloads.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path where the directory should be created
+	 * @param types Bitwise OR of ftp_checksum_type_t flags, FTP_CHECKSUM_NONE to disable (default)
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if directory creation fails
+	 * @note CRC32C uses the SSE4.2 or ARMv8 CRC instructions when the compiler
+	 *       targets them (e.g. -msse4.2 or -march=native), and a table otherwise.
+	 *       Resumed transfers hash only the bytes moved by that call. Downloads
+	 *       that ftp_client_download_parallel() splits into segments are not
+	 *       hashed; afterwards ftp_client_get_checksums() reports no checksums.
+	 */
+	void ftp_client_set_checksums(ftp_client_t *client, unsigned int types);
+
+	/**
+	 * @brief Get the checksums of the last upload or download
 	 *
-	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
-	 *       paths from the FTP root, or provide relative paths otherwise.
-	 *       Parent directories must exist. This function does not create
-	 *       intermediate directories recursively. Some servers may return
-	 *       an error if the directory already exists.
+	 * @param client Pointer to the FTP client handle
+	 * @param checksums Pointer to receive the digests; checksums->types is 0 if
+	 *                  no checksums were computed
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
 	 *
 	 * Example:
 	 * @code
-	 * if (ftp_client_mkdir(client, "/uploads/new_folder") != FTP_OK) {
-	 *     fprintf(stderr, "Failed to create directory: %s\n",
-	 *             ftp_client_get_error(client));
+	 * ftp_checksums_t sums;
+	 * ftp_client_set_checksums(client, FTP_CHECKSUM_CRC32C | FTP_CHECKSUM_SHA256);
+	 * if (ftp_client_download(client, "/data.bin", "data.bin") == FTP_OK &&
+	 *     ftp_client_get_checksums(client, &sums) == FTP_OK) {
+	 *     printf("crc32c %08x over %lld bytes\n", sums.crc32c, (long long)sums.bytes);
 	 * }
 	 * @endcode
 	 */
-	int ftp_client_mkdir(ftp_client_t *client, const char *remote_path);
+	int ftp_client_get_checksums(ftp_client_t *client, ftp_checksums_t *checksums);
 
 	/**
-	 * @brief Remove a directory from the FTP server
+	 * @brief Enable MODE Z (deflate) compressed transfers
 	 *
-	 * Deletes an empty directory from the FTP server.
+	 * When the server announces MODE Z in its FEAT reply, uploads are deflated
+	 * and downloads inflated on the fly, so text-heavy files cross the network
+	 * in a fraction of their size. Servers without MODE Z get plain transfers.
+	 * Applies to ftp_client_upload() and its memory/iovec variants,
+	 * ftp_client_download() and the to_memory, to_buffer and to_callback downloads.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path to the directory to remove
+	 * @param level zlib compression level from 1 (fastest) to 9 (smallest) for
+	 *              uploads, or 0 to disable compression (default)
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if removal fails
-	 *
-	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
-	 *       paths from the FTP root, or provide relative paths otherwise.
-	 *       The directory must be empty before it can be removed.
-	 *       Use ftp_client_delete() to remove files first if needed.
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if the level is
+	 *         out of range or the library was built without FTP_CLIENT_ENABLE_ZLIB
 	 *
-	 * Example:
-	 * @code
-	 * if (ftp_client_rmdir(client, "/uploads/old_folder") != FTP_OK) {
-	 *     fprintf(stderr, "Failed to remove directory: %s\n",
-	 *             ftp_client_get_error(client));
-	 * }
-	 * @endcode
+	 * @note The file size announced by the server is not known up front for
+	 *       compressed downloads, so they are not presized or preallocated.
+	 *       Downloads resumed at an offset are not compressed, and compressed
+	 *       downloads that end before the end of the zlib stream fail with
+	 *       FTP_ERROR_TRANSFER. Progress callbacks report compressed bytes.
 	 */
-	int ftp_client_rmdir(ftp_client_t *client, const char *remote_path);
+	int ftp_client_set_compression(ftp_client_t *client, int level);
 
 	/**
-	 * @brief Delete a file from the FTP server
-	 *
-	 * Removes a file from the FTP server.
+	 * @brief Get the compression summary of the last upload or download
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path to the file to delete
-	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if deletion fails
+	 * @param stats Pointer to receive the summary; all fields are 0 if the
+	 *              transfer was not compressed
 	 *
-	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
-	 *       paths from the FTP root, or provide relative paths otherwise.
-	 *       This operation is permanent and cannot be undone.
-	 *       To remove directories, use ftp_client_rmdir() instead.
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
 	 *
 	 * Example:
 	 * @code
-	 * if (ftp_client_delete(client, "/uploads/old_file.txt") != FTP_OK) {
-	 *     fprintf(stderr, "Failed to delete file: %s\n",
-	 *             ftp_client_get_error(client));
+	 * ftp_compression_stats_t stats;
+	 * ftp_client_set_compression(client, 6);
+	 * if (ftp_client_upload(client, "access.log", "/logs/access.log") == FTP_OK &&
+	 *     ftp_client_get_compression_stats(client, &stats) == FTP_OK && stats.compressed) {
+	 *     printf("%lld bytes sent as %lld\n", (long long)stats.raw_bytes, (long long)stats.wire_bytes);
 	 * }
 	 * @endcode
 	 */
-	int ftp_client_delete(ftp_client_t *client, const char *remote_path);
+	int ftp_client_get_compression_stats(ftp_client_t *client, ftp_compression_stats_t *stats);
 
 	/**
-	 * @brief Rename or move a file or directory on the FTP server
+	 * @brief Enable or disable persistent session mode
 	 *
-	 * Renames or moves a file or directory from one path to another.
+	 * In session mode the client keeps its libcurl option state between operations
+	 * instead of resetting and reconfiguring the handle for every call, and keeps
+	 * the logged-in control connection alive with TCP keepalive probes. Later
+	 * operations reuse the existing connection without reconnecting or logging in again.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param old_path Current path of the file or directory
-	 * @param new_path New path for the file or directory
-	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if rename fails
+	 * @param enable 1 to enable session mode, 0 to disable (default)
 	 *
-	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
-	 *       paths from the FTP root, or provide relative paths otherwise.
-	 *       This can be used to move files between directories if the server
-	 *       supports it. The destination directory must exist. If a file with
-	 *       the new name already exists, behavior depends on the server.
+	 * @note Changing any client setting (host, credentials, mode, SSL, timeouts,
+	 *       verbosity, progress callback) makes the next operation reapply the full
+	 *       configuration once. Use ftp_client_get_session_stats() to verify reuse.
 	 *
 	 * Example:
 	 * @code
-	 * // Rename a file
-	 * ftp_client_rename(client, "/uploads/old_name.txt", "/uploads/new_name.txt");
-	 *
-	 * // Move a file to different directory
-	 * ftp_client_rename(client, "/temp/file.txt", "/archive/file.txt");
+	 * ftp_client_set_session_reuse(client, 1);
+	 * ftp_client_connect(client);              // Logs in once
+	 * ftp_client_mkdir(client, "/jobs/42");    // Reuses the control connection
 	 * @endcode
 	 */
-	int ftp_client_rename(ftp_client_t *client, const char *old_path, const char *new_path);
+	void ftp_client_set_session_reuse(ftp_client_t *client, int enable);
 
 	/**
-	 * @brief Get file size on the FTP server
+	 * @brief Get session reuse statistics
 	 *
-	 * Retrieves the size of a file on the FTP server without downloading it.
+	 * Reports how many operations the client has performed, how many new control
+	 * connections (and therefore logins) they opened, and how many successful
+	 * operations ran over an already logged-in control connection.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param remote_path Path to the file on the FTP server
-	 * @param size Pointer to receive the file size in bytes
-	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if operation fails
+	 * @param stats Pointer to receive the statistics
 	 *
-	 * @note This uses the FTP SIZE command, which may not be supported by all servers.
-	 *       The size value is only updated on success.
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
 	 *
 	 * Example:
 	 * @code
-	 * int64_t file_size;
-	 * if (ftp_client_get_filesize(client, "/data/large_file.bin", &file_size) == FTP_OK) {
-	 *     printf("File size: %lld bytes\n", (long long)file_size);
+	 * ftp_session_stats_t stats;
+	 * if (ftp_client_get_session_stats(client, &stats) == FTP_OK) {
+	 *     printf("%lu of %lu operations reused the connection\n",
+	 *            stats.connections_reused, stats.operations);
 	 * }
 	 * @endcode
 	 */
-	int ftp_client_get_filesize(ftp_client_t *client, const char *remote_path, int64_t *size);
+	int ftp_client_get_session_stats(ftp_client_t *client, ftp_session_stats_t *stats);
 
 	/**
-	 * @brief Execute custom FTP command
+	 * @brief Get the timing breakdown and byte counts of the last operation
 	 *
-	 * Sends a raw FTP command to the server and optionally retrieves the response.
+	 * Every operation that talks to the server (transfers, listings, commands,
+	 * size queries) replaces these statistics when it finishes, whether it
+	 * succeeded or not. An operation that fails before reaching the server,
+	 * or is answered from the metadata cache, leaves all fields 0. They come from libcurl's transfer information, so they
+	 * show whether time went into name resolution, connecting, the TLS
+	 * handshake, logging in or waiting for the server.
 	 *
 	 * @param client Pointer to the FTP client handle
-	 * @param command Raw FTP command to execute (e.g., "SITE CHMOD 755 file.txt")
-	 * @param response Pointer to receive server response (NULL if not needed)
+	 * @param stats Pointer to receive the statistics; all fields are 0 before
+	 *              the first operation
 	 *
-	 * @return FTP_OK (0) on success
-	 *         FTP_ERROR_INVALID_PARAM (-7) if client or command is NULL
-	 *         FTP_ERROR_TRANSFER (-4) if command execution fails
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
 	 *
-	 * @note The caller is responsible for freeing the response string if provided.
-	 *       This is an advanced function - incorrect commands may leave the
-	 *       connection in an inconsistent state.
+	 * @note Operations that issue several requests (such as restarted downloads
+	 *       or the SIZE query before a presized download) report the last one;
+	 *       ftp_client_download_parallel() reports all segments combined.
+	 *       Byte counts are bytes on the data connection, so compressed
+	 *       transfers report compressed sizes.
 	 *
 	 * Example:
 	 * @code
-	 * char *response = NULL;
-	 * if (ftp_client_execute_command(client, "STAT", &response) == FTP_OK) {
-	 *     printf("Server status:\n%s\n", response);
-	 *     free(response);
+	 * ftp_transfer_stats_t stats;
+	 * ftp_client_download(client, "/data/big.bin", "big.bin");
+	 * if (ftp_client_get_transfer_stats(client, &stats) == FTP_OK) {
+	 *     printf("dns %.3fs connect %.3fs tls %.3fs ready %.3fs first byte %.3fs total %.3fs\n",
+	 *            stats.namelookup_time, stats.connect_time, stats.appconnect_time,
+	 *            stats.pretransfer_time, stats.starttransfer_time, stats.total_time);
 	 * }
 	 * @endcode
 	 */
-	int ftp_client_execute_command(ftp_client_t *client, const char *command, char **response);
+	int ftp_client_get_transfer_stats(ftp_client_t *client, ftp_transfer_stats_t *stats);
 
 	/**
-	 * @brief Get last error message
+	 * @brief Test connection to FTP server
 	 *
-	 * Returns a human-readable description of the last error that occurred.
+	 * Attempts to connect to the FTP server and authenticate using the configured
+	 * credentials. This verifies that the server is reachable and credentials are valid.
 	 *
 	 * @param client Pointer to the FTP client handle
 	 *
-	 * @return Pointer to error message string. Returns "Invalid client handle" if client is NULL.
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if client is NULL or host not set
+	 *         FTP_ERROR_AUTH (-3) if authentication fails
+	 *         FTP_ERROR_TIMEOUT (-10) if connection times out
+	 *         FTP_ERROR_CONNECTION (-2) for other connection errors
 	 *
-	 * @note The returned string is managed by the client handle and should not be freed.
-	 *       The error message is overwritten by subsequent operations.
+	 * @note This function executes a NOOP command to verify the connection.
+	 *       Use ftp_client_get_error() to retrieve detailed error messages.
 	 *
 	 * Example:
 	 * @code
-	 * if (ftp_client_upload(client, "file.txt", "/remote.txt") != FTP_OK) {
-	 *     fprintf(stderr, "Error: %s\n", ftp_client_get_error(client));
+	 * int result = ftp_client_connect(client);
+	 * if (result != FTP_OK) {
+	 *     fprintf(stderr, "Connection failed: %s\n", ftp_client_get_error(client));
+	 *     return -1;
 	 * }
+	 * printf("Connected successfully!\n");
 	 * @endcode
 	 */
-	const char *ftp_client_get_error(ftp_client_t *client);
+	int ftp_client_connect(ftp_client_t *client);
+
+	/**
+	 * @brief Upload a file to the FTP server
+	 *
+	 * Transfers a file from the local filesystem to the FTP server.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param local_path Path to the local file to upload
+	 * @param remote_path Destination path on the FTP server
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be opened
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * @note If progress callback is set, it will be called during the upload.
+	 *       Remote directories must exist before uploading to them.
+	 *
+	 * Example:
+	 * @code
+	 * int result = ftp_client_upload(client, "local_file.txt", "/upload/remote_file.txt");
+	 * if (result != FTP_OK) {
+	 *     fprintf(stderr, "Upload failed: %s\n", ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_upload(ftp_client_t *client, const char *local_path, const char *remote_path);
+
+	/**
+	 * @brief Resume an interrupted upload
+	 *
+	 * Queries the size of the remote file with SIZE and sends only the part of
+	 * the local file beyond that offset, appending it with APPE. If the remote
+	 * file does not exist, or the server does not support SIZE, the whole file
+	 * is uploaded as with ftp_client_upload().
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param local_path Path to the local file to upload
+	 * @param remote_path Destination path on the FTP server
+	 *
+	 * @return FTP_OK (0) on success, including when the remote file is already complete
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be opened or read
+	 *         FTP_ERROR_TRANSFER (-4) if the size query or the transfer fails;
+	 *         nothing is sent if the remote size cannot be queried
+	 *
+	 * @note The remote file is assumed to be a prefix of the local file. If the
+	 *       remote file is larger than the local file it is overwritten from the
+	 *       start. Progress callbacks report only the bytes sent by this call.
+	 *
+	 * Example:
+	 * @code
+	 * while (ftp_client_upload_resume(client, "dump.tar", "/backup/dump.tar") == FTP_ERROR_TRANSFER) {
+	 *     sleep(5);  // Retry; bytes already on the server are not sent again
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_upload_resume(ftp_client_t *client, const char *local_path, const char *remote_path);
+
+	/**
+	 * @brief Upload a memory buffer to the FTP server
+	 *
+	 * The data is handed to libcurl straight from the buffer, without a
+	 * temporary file.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param data Bytes to upload (may be NULL if size is 0)
+	 * @param size Number of bytes to upload
+	 * @param remote_path Destination path on the FTP server
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any required parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * @note The buffer must stay valid and unchanged until the call returns.
+	 *
+	 * Example:
+	 * @code
+	 * const char *report = build_report();
+	 * ftp_client_upload_from_memory(client, report, strlen(report), "/reports/daily.csv");
+	 * @endcode
+	 */
+	int ftp_client_upload_from_memory(ftp_client_t *client, const void *data, size_t size, const char *remote_path);
+
+	/**
+	 * @brief Upload several memory buffers as one remote file
+	 *
+	 * The segments are sent back to back in array order, so a header, a body and
+	 * a trailer built separately can be uploaded without joining them first.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param iov Array of segments; segments with iov_len 0 are skipped
+	 * @param count Number of segments
+	 * @param remote_path Destination path on the FTP server
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any required parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * Example:
+	 * @code
+	 * ftp_iovec_t parts[3] = {
+	 *     { header, header_len },
+	 *     { rows, rows_len },
+	 *     { footer, footer_len }
+	 * };
+	 * ftp_client_upload_iov(client, parts, 3, "/reports/daily.csv");
+	 * @endcode
+	 */
+	int ftp_client_upload_iov(ftp_client_t *client, const ftp_iovec_t *iov, size_t count, const char *remote_path);
+
+	/**
+	 * @brief Download a file from the FTP server
+	 *
+	 * Transfers a file from the FTP server to the local filesystem.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param local_path Destination path on the local filesystem
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be created
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if remote file doesn't exist
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * @note If progress callback is set, it will be called during the download.
+	 *       Partial files are deleted if the download fails, unless resume mode is
+	 *       enabled with ftp_client_set_download_resume().
+	 *
+	 * Example:
+	 * @code
+	 * int result = ftp_client_download(client, "/download/file.txt", "local_file.txt");
+	 * if (result != FTP_OK) {
+	 *     fprintf(stderr, "Download failed: %s\n", ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_download(ftp_client_t *client, const char *remote_path, const char *local_path);
+
+	/**
+	 * @brief Download a file into a newly allocated memory buffer
+	 *
+	 * When the server announces the file size, the buffer is allocated once at
+	 * its final size before the first byte arrives, so large files cost a
+	 * single allocation and no copies.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param data Pointer to receive the file contents (caller must free())
+	 * @param size Pointer to receive the number of bytes downloaded
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_MEMORY (-6) if the buffer cannot be allocated
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if remote file doesn't exist
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * @note The buffer is NUL-terminated after the last byte, so text files can
+	 *       be used as C strings. *data is NULL on failure.
+	 *
+	 * Example:
+	 * @code
+	 * char *config;
+	 * size_t length;
+	 * if (ftp_client_download_to_memory(client, "/etc/app.conf", &config, &length) == FTP_OK) {
+	 *     parse_config(config, length);
+	 *     free(config);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_download_to_memory(ftp_client_t *client, const char *remote_path, char **data, size_t *size);
+
+	/**
+	 * @brief Download a file into a caller-provided buffer
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param buffer Destination buffer
+	 * @param capacity Size of the destination buffer in bytes
+	 * @param size Pointer to receive the number of bytes downloaded
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_MEMORY (-6) if the file does not fit in the buffer
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if remote file doesn't exist
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails
+	 *
+	 * @note The buffer is not NUL-terminated. If the file does not fit and the
+	 *       server announced its size, the transfer stops before any data is
+	 *       copied and *size receives the required capacity; otherwise *size is 0.
+	 */
+	int ftp_client_download_to_buffer(ftp_client_t *client, const char *remote_path, void *buffer, size_t capacity,
+									  size_t *size);
+
+	/**
+	 * @brief Download a file into a callback as the data arrives
+	 *
+	 * Every received block is passed to the sink, so it can be decompressed,
+	 * parsed or forwarded while the rest of the file is still on its way,
+	 * without touching the disk.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param sink Callback receiving the data in order
+	 * @param user_data User data passed to the sink
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any required parameter is NULL
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if remote file doesn't exist
+	 *         FTP_ERROR_TRANSFER (-4) if transfer fails or the sink aborts it
+	 *
+	 * @note The sink returns FTP_SINK_CONTINUE after consuming the whole block,
+	 *       FTP_SINK_ABORT to stop the download, or FTP_SINK_PAUSE to consume
+	 *       nothing for now. A paused transfer stops reading from the network and
+	 *       offers the same block again on the next progress tick (at most about a
+	 *       second later). Pauses count towards the client's transfer timeout.
+	 *
+	 * Example:
+	 * @code
+	 * static int feed(void *user_data, const void *data, size_t size)
+	 * {
+	 *     return parser_feed((parser_t *)user_data, data, size) == 0 ? FTP_SINK_CONTINUE : FTP_SINK_ABORT;
+	 * }
+	 *
+	 * ftp_client_download_to_callback(client, "/logs/today.log", feed, parser);
+	 * @endcode
+	 */
+	int ftp_client_download_to_callback(ftp_client_t *client, const char *remote_path, ftp_sink_callback_t sink,
+										void *user_data);
+
+	/**
+	 * @brief Download a file over several connections in parallel
+	 *
+	 * Splits the remote file into byte ranges and fetches each range over its own
+	 * connection (using REST offsets) at the same time. Each range is written in
+	 * place into a local file whose disk space is reserved up front, which lets a
+	 * single large download use several TCP streams on high-latency links
+	 * without fragmenting the file.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param local_path Destination path on the local filesystem
+	 * @param nsegments Number of parallel connections to use
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_IO (-9) if local file cannot be created or the disk cannot hold it
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if the remote file does not exist
+	 *         FTP_ERROR_TRANSFER (-4) if the size query or any segment fails
+	 *
+	 * @note The server must support SIZE and REST. Segments are never smaller than
+	 *       FTP_MIN_SEGMENT_SIZE bytes, so small files fall back to a single
+	 *       ftp_client_download(). The progress callback receives the combined
+	 *       progress of all segments; returning non-zero aborts all of them.
+	 *       Partial files are deleted if the download fails.
+	 *
+	 * Example:
+	 * @code
+	 * int result = ftp_client_download_parallel(client, "/images/disk.img", "disk.img", 8);
+	 * if (result != FTP_OK) {
+	 *     fprintf(stderr, "Download failed: %s\n", ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_download_parallel(ftp_client_t *client, const char *remote_path, const char *local_path,
+									 int nsegments);
+
+	/**
+	 * @brief List directory contents on the FTP server
+	 *
+	 * Retrieves a listing of files and directories in the specified path.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the directory on the FTP server
+	 * @param output Pointer to receive the allocated string with directory listing
+	 *
+	 * @return FTP_OK (0) on success, error code on failure
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if listing fails
+	 *
+	 * @note The caller is responsible for freeing the allocated output string.
+	 *       The format of the listing depends on the FTP server (typically Unix-style ls format).
+	 *
+	 * Example:
+	 * @code
+	 * char *listing = NULL;
+	 * if (ftp_client_list_dir(client, "/", &listing) == FTP_OK) {
+	 *     printf("Directory contents:\n%s\n", listing);
+	 *     free(listing);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_list_dir(ftp_client_t *client, const char *remote_path, char **output);
+
+	/**
+	 * @brief List directory contents as parsed entries
+	 *
+	 * Retrieves the directory listing with MLSD, whose machine-readable format
+	 * gives exact sizes, UTC modification times and types. Server support is
+	 * detected with FEAT on first use and remembered by the client. Servers
+	 * without MLSD are listed with LIST, parsed as by ftp_entry_list_parse().
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the directory on the FTP server
+	 * @param list Pointer to the list to fill; release it with ftp_entry_list_free()
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_TRANSFER (-4) if listing fails
+	 *
+	 * @note The "." and ".." entries are omitted. Entry names point into
+	 *       list->arena and stay valid until ftp_entry_list_free() is called.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_entry_list_t list;
+	 * if (ftp_client_list_entries(client, "/pub", &list) == FTP_OK) {
+	 *     for (size_t i = 0; i < list.count; i++) {
+	 *         printf("%c %10lld %s\n", list.entries[i].type == FTP_ENTRY_DIR ? 'd' : '-',
+	 *                (long long)list.entries[i].size, list.entries[i].name);
+	 *     }
+	 *     ftp_entry_list_free(&list);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_list_entries(ftp_client_t *client, const char *remote_path, ftp_entry_list_t *list);
+
+	/**
+	 * @brief Parse raw LIST output into directory entries
+	 *
+	 * Parses the text returned by ftp_client_list_dir() in the Unix "ls -l" or
+	 * DOS/IIS format into the same entries that ftp_client_list_entries() returns.
+	 * The formats may be mixed line by line; lines in neither format are skipped.
+	 *
+	 * @param listing Raw listing text (need not be NUL-terminated)
+	 * @param size Length of the listing in bytes
+	 * @param list Pointer to the list to fill; release it with ftp_entry_list_free()
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if listing or list is NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *
+	 * @note LIST times are in the server's local time zone and are reported as if
+	 *       they were UTC. Entries listed with "HH:MM" instead of a year are
+	 *       assumed to lie within the past year. Symbolic link targets are removed
+	 *       from the name, and the "." and ".." entries are omitted.
+	 *
+	 * Example:
+	 * @code
+	 * char *raw = NULL;
+	 * ftp_entry_list_t list;
+	 * if (ftp_client_list_dir(client, "/", &raw) == FTP_OK) {
+	 *     if (ftp_entry_list_parse(raw, strlen(raw), &list) == FTP_OK) {
+	 *         printf("%zu entries\n", list.count);
+	 *         ftp_entry_list_free(&list);
+	 *     }
+	 *     free(raw);
+	 * }
+	 * @endcode
+	 */
+	int ftp_entry_list_parse(const char *listing, size_t size, ftp_entry_list_t *list);
+
+	/**
+	 * @brief Free a directory listing
+	 *
+	 * Releases the entries and the name arena of a list filled by
+	 * ftp_client_list_entries() or ftp_entry_list_parse() and resets it to an
+	 * empty list.
+	 *
+	 * @param list Pointer to the list (NULL is ignored)
+	 */
+	void ftp_entry_list_free(ftp_entry_list_t *list);
+
+	/**
+	 * @brief Stream directory entries to a callback as they arrive
+	 *
+	 * Lists a directory like ftp_client_list_entries(), but parses each line as
+	 * soon as it has been received and hands the entry to a callback instead of
+	 * collecting the listing. Memory use is bounded by the longest line.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the directory on the FTP server
+	 * @param on_entry Function called once per entry
+	 * @param user_data User data passed to the callback
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if client or on_entry is NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_TRANSFER (-4) if listing fails or the callback stopped it
+	 *
+	 * @note The entry and its name are only valid during the callback; copy what
+	 *       you need to keep. Lines that cannot be parsed are skipped, and so
+	 *       are the "." and ".." entries.
+	 *
+	 * Example:
+	 * @code
+	 * static int count_files(void *user_data, const ftp_entry_t *entry)
+	 * {
+	 *     if (entry->type == FTP_ENTRY_FILE) (*(size_t *)user_data)++;
+	 *     return 0;  // Continue
+	 * }
+	 *
+	 * size_t files = 0;
+	 * ftp_client_list_dir_stream(client, "/huge", count_files, &files);
+	 * @endcode
+	 */
+	int ftp_client_list_dir_stream(ftp_client_t *client, const char *remote_path, ftp_entry_callback_t on_entry,
+								   void *user_data);
+
+	/**
+	 * @brief Create a directory on the FTP server
+	 *
+	 * Creates a new directory at the specified path on the FTP server.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path where the directory should be created
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if directory creation fails
+	 *
+	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
+	 *       paths from the FTP root, or provide relative paths otherwise.
+	 *       Parent directories must exist. This function does not create
+	 *       intermediate directories recursively. Some servers may return
+	 *       an error if the directory already exists.
+	 *
+	 * Example:
+	 * @code
+	 * if (ftp_client_mkdir(client, "/uploads/new_folder") != FTP_OK) {
+	 *     fprintf(stderr, "Failed to create directory: %s\n",
+	 *             ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_mkdir(ftp_client_t *client, const char *remote_path);
+
+	/**
+	 * @brief Remove a directory from the FTP server
+	 *
+	 * Deletes an empty directory from the FTP server.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the directory to remove
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if removal fails
+	 *
+	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
+	 *       paths from the FTP root, or provide relative paths otherwise.
+	 *       The directory must be empty before it can be removed.
+	 *       Use ftp_client_delete() to remove files first if needed.
+	 *
+	 * Example:
+	 * @code
+	 * if (ftp_client_rmdir(client, "/uploads/old_folder") != FTP_OK) {
+	 *     fprintf(stderr, "Failed to remove directory: %s\n",
+	 *             ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_rmdir(ftp_client_t *client, const char *remote_path);
+
+	/**
+	 * @brief Delete a file from the FTP server
+	 *
+	 * Removes a file from the FTP server.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file to delete
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if deletion fails
+	 *
+	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
+	 *       paths from the FTP root, or provide relative paths otherwise.
+	 *       This operation is permanent and cannot be undone.
+	 *       To remove directories, use ftp_client_rmdir() instead.
+	 *
+	 * Example:
+	 * @code
+	 * if (ftp_client_delete(client, "/uploads/old_file.txt") != FTP_OK) {
+	 *     fprintf(stderr, "Failed to delete file: %s\n",
+	 *             ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_delete(ftp_client_t *client, const char *remote_path);
+
+	/**
+	 * @brief Rename or move a file or directory on the FTP server
+	 *
+	 * Renames or moves a file or directory from one path to another.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param old_path Current path of the file or directory
+	 * @param new_path New path for the file or directory
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if rename fails
+	 *
+	 * @note Paths are sent to the server as-is. Use a leading '/' for absolute
+	 *       paths from the FTP root, or provide relative paths otherwise.
+	 *       This can be used to move files between directories if the server
+	 *       supports it. The destination directory must exist. If a file with
+	 *       the new name already exists, behavior depends on the server.
+	 *
+	 * Example:
+	 * @code
+	 * // Rename a file
+	 * ftp_client_rename(client, "/uploads/old_name.txt", "/uploads/new_name.txt");
+	 *
+	 * // Move a file to different directory
+	 * ftp_client_rename(client, "/temp/file.txt", "/archive/file.txt");
+	 * @endcode
+	 */
+	int ftp_client_rename(ftp_client_t *client, const char *old_path, const char *new_path);
+
+	/**
+	 * @brief Get file size on the FTP server
+	 *
+	 * Retrieves the size of a file on the FTP server without downloading it.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param size Pointer to receive the file size in bytes
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if the remote file does not exist
+	 *         FTP_ERROR_TRANSFER (-4) if operation fails
+	 *
+	 * @note This uses the FTP SIZE command, which may not be supported by all servers.
+	 *       The size value is only updated on success.
+	 *
+	 * Example:
+	 * @code
+	 * int64_t file_size;
+	 * if (ftp_client_get_filesize(client, "/data/large_file.bin", &file_size) == FTP_OK) {
+	 *     printf("File size: %lld bytes\n", (long long)file_size);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_get_filesize(ftp_client_t *client, const char *remote_path, int64_t *size);
+
+	/**
+	 * @brief Get the modification time of a file on the FTP server
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param remote_path Path to the file on the FTP server
+	 * @param mtime Pointer to receive the time in seconds since the Unix epoch
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_FILE_NOT_FOUND (-5) if the remote file does not exist
+	 *         FTP_ERROR_TRANSFER (-4) if the time cannot be retrieved
+	 *
+	 * @note Uses MDTM, so the server must support it. The size is fetched in the
+	 *       same round trip and both are cached if a cache is attached.
+	 *
+	 * Example:
+	 * @code
+	 * int64_t mtime;
+	 * if (ftp_client_get_mtime(client, "/remote/file.txt", &mtime) == FTP_OK) {
+	 *     printf("Modified: %lld\n", (long long)mtime);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_get_mtime(ftp_client_t *client, const char *remote_path, int64_t *mtime);
+
+	/**
+	 * @brief Create a metadata cache
+	 *
+	 * The cache holds file sizes, modification times and ftp_client_list_dir()
+	 * results, so repeated queries for the same paths skip the network. Attach
+	 * it to one or more clients with ftp_client_set_cache(); entries are keyed
+	 * by server and user, so clients of different servers can share it.
+	 *
+	 * @param ttl Seconds an entry stays valid (must be > 0)
+	 * @param max_entries Maximum number of cached paths; the least recently used
+	 *                    entry is evicted when it is full (0 for 4096)
+	 *
+	 * @return Pointer to a new ftp_cache_t on success, NULL on failure
+	 *
+	 * @note All cache functions are thread-safe.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_cache_t *cache = ftp_cache_create(30, 0);
+	 * ftp_client_set_cache(client, cache);
+	 * ftp_client_get_filesize(client, "/a.txt", &size);  // Network
+	 * ftp_client_get_filesize(client, "/a.txt", &size);  // Cache
+	 * @endcode
+	 */
+	ftp_cache_t *ftp_cache_create(long ttl, size_t max_entries);
+
+	/**
+	 * @brief Attach a metadata cache to a client
+	 *
+	 * While attached, ftp_client_get_filesize(), ftp_client_get_mtime() and
+	 * ftp_client_list_dir() answer from the cache when possible. Uploads,
+	 * deletes, renames and directory changes made through the client update
+	 * or invalidate the affected entries.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param cache Cache to use, or NULL to detach
+	 *
+	 * @note The cache must outlive every client it is attached to. Changes made
+	 *       by other programs or with ftp_client_execute_command() are only
+	 *       noticed when entries expire. ftp_client_duplicate() copies the
+	 *       attachment. Operations whose offsets depend on the current remote
+	 *       size, ftp_client_upload_resume() and ftp_client_download_parallel(),
+	 *       always ask the server.
+	 */
+	void ftp_client_set_cache(ftp_client_t *client, ftp_cache_t *cache);
+
+	/**
+	 * @brief Remove all entries from a cache
+	 *
+	 * @param cache Pointer to the cache (NULL is ignored)
+	 */
+	void ftp_cache_clear(ftp_cache_t *cache);
+
+	/**
+	 * @brief Get cache statistics
+	 *
+	 * @param cache Pointer to the cache
+	 * @param stats Pointer to receive the statistics
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 */
+	int ftp_cache_get_stats(ftp_cache_t *cache, ftp_cache_stats_t *stats);
+
+	/**
+	 * @brief Destroy a cache
+	 *
+	 * @param cache Pointer to the cache (NULL is ignored)
+	 *
+	 * @note Detach it from all clients first.
+	 */
+	void ftp_cache_destroy(ftp_cache_t *cache);
+
+	/**
+	 * @brief Limit the bandwidth of a single client
+	 *
+	 * Caps the send and receive rates of the client's own transfers, directory
+	 * listings and command replies with a token bucket. The segments of
+	 * ftp_client_download_parallel() share the cap. Copies made with
+	 * ftp_client_duplicate() get caps of their own with the same rates.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param send_rate Upload limit in bytes per second, 0 for unlimited (default)
+	 * @param receive_rate Download limit in bytes per second, 0 for unlimited (default)
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if client is NULL,
+	 *         FTP_ERROR_MEMORY (-6) if the limiter cannot be allocated
+	 *
+	 * @note May be called while a transfer runs, e.g. from the progress
+	 *       callback; the new rates apply to the rest of the transfer.
+	 */
+	int ftp_client_set_max_speed(ftp_client_t *client, int64_t send_rate, int64_t receive_rate);
+
+	/**
+	 * @brief Create a rate limiter shared by several clients
+	 *
+	 * All clients attached with ftp_client_set_rate_limiter() draw from the
+	 * same token buckets, so the limits hold for the sum of their concurrent
+	 * transfers across threads. Bursts are limited to a quarter second of
+	 * traffic.
+	 *
+	 * @param send_rate Aggregate upload limit in bytes per second, 0 for unlimited
+	 * @param receive_rate Aggregate download limit in bytes per second, 0 for unlimited
+	 *
+	 * @return Pointer to the new limiter, or NULL on allocation failure
+	 *
+	 * Example:
+	 * @code
+	 * ftp_rate_limiter_t *wan = ftp_rate_limiter_create(10 * 1024 * 1024, 0);  // 10 MB/s up
+	 * ftp_client_set_rate_limiter(client, wan);
+	 * ftp_pool_t *pool = ftp_pool_create(client, NULL);  // All sessions share the limit
+	 * @endcode
+	 */
+	ftp_rate_limiter_t *ftp_rate_limiter_create(int64_t send_rate, int64_t receive_rate);
+
+	/**
+	 * @brief Change the rates of a shared limiter
+	 *
+	 * Safe to call from any thread; running transfers slow down or speed up
+	 * without being restarted.
+	 *
+	 * @param limiter Pointer to the limiter (NULL is ignored)
+	 * @param send_rate Aggregate upload limit in bytes per second, 0 for unlimited
+	 * @param receive_rate Aggregate download limit in bytes per second, 0 for unlimited
+	 */
+	void ftp_rate_limiter_set_rates(ftp_rate_limiter_t *limiter, int64_t send_rate, int64_t receive_rate);
+
+	/**
+	 * @brief Attach a shared rate limiter to a client
+	 *
+	 * Applies to uploads and downloads of the client, parallel segmented
+	 * downloads, and everything run through ftp_pool_t, ftp_transfer_queue_t,
+	 * ftp_async_t, ftp_walk() or ftp_sync() created from it. With
+	 * compression enabled the limits count compressed bytes.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param limiter Limiter to draw from, or NULL to detach
+	 *
+	 * @note The limiter must outlive every client it is attached to.
+	 *       ftp_client_duplicate() copies the attachment.
+	 */
+	void ftp_client_set_rate_limiter(ftp_client_t *client, ftp_rate_limiter_t *limiter);
+
+	/**
+	 * @brief Destroy a rate limiter
+	 *
+	 * @param limiter Pointer to the limiter (NULL is ignored)
+	 */
+	void ftp_rate_limiter_destroy(ftp_rate_limiter_t *limiter);
+
+	/**
+	 * @brief Execute custom FTP command
+	 *
+	 * Sends a raw FTP command to the server and optionally retrieves the response.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param command Raw FTP command to execute (e.g., "SITE CHMOD 755 file.txt")
+	 * @param response Pointer to receive server response (NULL if not needed)
+	 *
+	 * @return FTP_OK (0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if client or command is NULL
+	 *         FTP_ERROR_TRANSFER (-4) if command execution fails
+	 *
+	 * @note The caller is responsible for freeing the response string if provided.
+	 *       This is an advanced function - incorrect commands may leave the
+	 *       connection in an inconsistent state.
+	 *
+	 * Example:
+	 * @code
+	 * char *response = NULL;
+	 * if (ftp_client_execute_command(client, "STAT", &response) == FTP_OK) {
+	 *     printf("Server status:\n%s\n", response);
+	 *     free(response);
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_execute_command(ftp_client_t *client, const char *command, char **response);
+
+	/**
+	 * @brief Execute several FTP commands in one session
+	 *
+	 * Sends all commands over a single control connection in one operation
+	 * and records the server reply for each of them.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 * @param commands Array of raw FTP commands (e.g., "DELE /tmp/a.txt")
+	 * @param count Number of commands
+	 * @param results Array of count entries receiving each reply (NULL if not needed)
+	 * @param policy FTP_BATCH_STOP_ON_ERROR to stop at the first failing command,
+	 *               FTP_BATCH_CONTINUE_ON_ERROR to send every command regardless
+	 *
+	 * @return FTP_OK (0) if every command succeeded
+	 *         FTP_ERROR_INVALID_PARAM (-7) if client, commands or any command is NULL, or count is 0
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_TRANSFER (-4) if any command failed or the session could not run
+	 *
+	 * @note A reply code of 400 or above counts as a failure. Commands that were
+	 *       never sent have a code of 0. Reply text holds the complete reply,
+	 *       one line per reply line, truncated to FTP_REPLY_TEXT_SIZE - 1 bytes.
+	 *       Commands that open a data connection (LIST, RETR, ...) are not supported.
+	 *
+	 * Example:
+	 * @code
+	 * const char *cmds[] = { "MKD /new", "RNFR /a.txt", "RNTO /new/a.txt", "DELE /b.txt" };
+	 * ftp_command_result_t results[4];
+	 * if (ftp_client_execute_batch(client, cmds, 4, results, FTP_BATCH_CONTINUE_ON_ERROR) != FTP_OK) {
+	 *     for (int i = 0; i < 4; i++) {
+	 *         if (results[i].code >= 400) printf("%s: %s\n", cmds[i], results[i].text);
+	 *     }
+	 * }
+	 * @endcode
+	 */
+	int ftp_client_execute_batch(ftp_client_t *client, const char *const *commands, size_t count,
+								 ftp_command_result_t *results, ftp_batch_policy_t policy);
+
+	/**
+	 * @brief Get last error message
+	 *
+	 * Returns a human-readable description of the last error that occurred.
+	 *
+	 * @param client Pointer to the FTP client handle
+	 *
+	 * @return Pointer to error message string. Returns "Invalid client handle" if client is NULL.
+	 *
+	 * @note The returned string is managed by the client handle and should not be freed.
+	 *       The error message is overwritten by subsequent operations.
+	 *
+	 * Example:
+	 * @code
+	 * if (ftp_client_upload(client, "file.txt", "/remote.txt") != FTP_OK) {
+	 *     fprintf(stderr, "Error: %s\n", ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	const char *ftp_client_get_error(ftp_client_t *client);
+
+	/**
+	 * @brief Destroy FTP client handle and free resources
+	 *
+	 * Cleans up and deallocates an FTP client handle.
+	 *
+	 * @param client Pointer to the FTP client handle to destroy
+	 *
+	 * @note After calling this function, the client pointer is invalid and should not be used.
+	 *       It is safe to pass NULL to this function (it will do nothing).
+	 *       This does not call ftp_global_cleanup() - that must be called separately.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_client_destroy(client);
+	 * client = NULL;  // Good practice to avoid dangling pointer
+	 * @endcode
+	 */
+	void ftp_client_destroy(ftp_client_t *client);
+
+	/**
+	 * @brief Create a new client handle with the same configuration
+	 *
+	 * Allocates a new FTP client handle that copies the host, credentials,
+	 * transfer mode, SSL, timeout, verbosity, session and progress settings of
+	 * an existing client. The new handle has its own libcurl handle and connection.
+	 *
+	 * @param client Pointer to the FTP client handle to copy
+	 *
+	 * @return Pointer to a new ftp_client_t handle on success, NULL on failure
+	 *
+	 * @note This is the recommended way to give each thread its own handle.
+	 *       The copy must be destroyed with ftp_client_destroy().
+	 *
+	 * Example:
+	 * @code
+	 * ftp_client_t *worker = ftp_client_duplicate(client);
+	 * if (worker) {
+	 *     ftp_client_download(worker, "/data/part1.bin", "part1.bin");
+	 *     ftp_client_destroy(worker);
+	 * }
+	 * @endcode
+	 */
+	ftp_client_t *ftp_client_duplicate(const ftp_client_t *client);
+
+	/**
+	 * @brief Initialize connection pool options with default values
+	 *
+	 * @param options Pointer to the options structure to initialize
+	 *
+	 * @note This function sets:
+	 *       - Minimum sessions: 1
+	 *       - Maximum sessions: 8
+	 *       - Idle timeout: 60 seconds (0 = never evict idle sessions)
+	 *       - Checkout timeout: 30 seconds (0 = wait forever)
+	 *
+	 * Example:
+	 * @code
+	 * ftp_pool_options_t options;
+	 * ftp_pool_init_options(&options);
+	 * options.max_sessions = 16;
+	 * @endcode
+	 */
+	void ftp_pool_init_options(ftp_pool_options_t *options);
+
+	/**
+	 * @brief Create a thread-safe pool of logged-in client sessions
+	 *
+	 * Creates a pool of client handles that share the configuration of a prototype
+	 * client. The pool logs in min_sessions sessions up front, grows on demand up
+	 * to max_sessions, and closes sessions that stay idle longer than idle_timeout
+	 * while keeping at least min_sessions open.
+	 *
+	 * @param prototype Configured client whose settings every session copies
+	 * @param options Pool options (NULL for defaults)
+	 *
+	 * @return Pointer to a new ftp_pool_t on success, NULL on failure
+	 *
+	 * @note Pool sessions always run in session mode (see ftp_client_set_session_reuse()).
+	 *       On failure, ftp_client_get_error(prototype) describes the reason.
+	 *       The prototype is not used after this call returns.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_pool_options_t options;
+	 * ftp_pool_init_options(&options);
+	 * options.min_sessions = 4;
+	 * options.max_sessions = 16;
+	 *
+	 * ftp_pool_t *pool = ftp_pool_create(client, &options);
+	 * if (!pool) {
+	 *     fprintf(stderr, "Pool creation failed: %s\n", ftp_client_get_error(client));
+	 * }
+	 * @endcode
+	 */
+	ftp_pool_t *ftp_pool_create(ftp_client_t *prototype, const ftp_pool_options_t *options);
+
+	/**
+	 * @brief Check out a logged-in session from the pool
+	 *
+	 * Returns the most recently used idle session. If none is idle and the pool is
+	 * below max_sessions, a new session is created and logged in. Otherwise the
+	 * call blocks until another thread checks a session in or checkout_timeout expires.
+	 *
+	 * @param pool Pointer to the connection pool
+	 *
+	 * @return Pointer to a client handle owned by the pool, NULL on failure or timeout
+	 *
+	 * @note This function is thread-safe. The session must be returned with
+	 *       ftp_pool_checkin() or ftp_pool_discard() and must not be destroyed directly.
+	 *       Use ftp_pool_get_error() to retrieve the reason for a failure.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_client_t *session = ftp_pool_checkout(pool);
+	 * if (session) {
+	 *     ftp_client_upload(session, "report.csv", "/reports/report.csv");
+	 *     ftp_pool_checkin(pool, session);
+	 * }
+	 * @endcode
+	 */
+	ftp_client_t *ftp_pool_checkout(ftp_pool_t *pool);
+
+	/**
+	 * @brief Return a session to the pool
+	 *
+	 * Puts a checked-out session back on the idle list so other threads can use it.
+	 *
+	 * @param pool Pointer to the connection pool
+	 * @param client Session previously returned by ftp_pool_checkout()
+	 *
+	 * @note This function is thread-safe. Settings changed on the session while it
+	 *       was checked out stay in effect for the next user.
+	 *
+	 * @see ftp_pool_discard()
+	 */
+	void ftp_pool_checkin(ftp_pool_t *pool, ftp_client_t *client);
+
+	/**
+	 * @brief Close a checked-out session instead of returning it to the pool
+	 *
+	 * Use this when a session is known to be broken, e.g. after a connection or
+	 * authentication error. The pool creates a replacement on demand.
+	 *
+	 * @param pool Pointer to the connection pool
+	 * @param client Session previously returned by ftp_pool_checkout()
+	 *
+	 * @note This function is thread-safe.
+	 */
+	void ftp_pool_discard(ftp_pool_t *pool, ftp_client_t *client);
+
+	/**
+	 * @brief Close sessions that have been idle longer than the idle timeout
+	 *
+	 * Eviction also happens automatically on checkout and checkin. Call this
+	 * periodically if the pool may sit unused for long periods.
+	 *
+	 * @param pool Pointer to the connection pool
+	 *
+	 * @return Number of sessions closed
+	 *
+	 * @note At least min_sessions sessions are kept open.
+	 */
+	size_t ftp_pool_evict_idle(ftp_pool_t *pool);
+
+	/**
+	 * @brief Get connection pool statistics
+	 *
+	 * @param pool Pointer to the connection pool
+	 * @param stats Pointer to receive the statistics
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *
+	 * Example:
+	 * @code
+	 * ftp_pool_stats_t stats;
+	 * ftp_pool_get_stats(pool, &stats);
+	 * printf("%zu sessions (%zu idle), %lu created\n", stats.total, stats.idle, stats.created);
+	 * @endcode
+	 */
+	int ftp_pool_get_stats(ftp_pool_t *pool, ftp_pool_stats_t *stats);
+
+	/**
+	 * @brief Get the last pool error message
+	 *
+	 * @param pool Pointer to the connection pool
+	 *
+	 * @return Pointer to the error message of the most recent failed checkout.
+	 *         Returns "Invalid pool handle" if pool is NULL.
+	 *
+	 * @note The message is shared by all threads using the pool.
+	 */
+	const char *ftp_pool_get_error(ftp_pool_t *pool);
+
+	/**
+	 * @brief Destroy a connection pool and close all its sessions
+	 *
+	 * @param pool Pointer to the connection pool (NULL is ignored)
+	 *
+	 * @note All checked-out sessions must be checked in or discarded first.
+	 */
+	void ftp_pool_destroy(ftp_pool_t *pool);
+
+	/**
+	 * @brief Create a multi-file transfer queue drained by worker threads
+	 *
+	 * Starts a fixed number of worker threads, each with its own client handle
+	 * copied from the prototype and kept logged in between jobs. Jobs submitted
+	 * with ftp_transfer_queue_submit() run in submission order on whichever
+	 * worker is free.
+	 *
+	 * @param prototype Configured client whose settings every worker copies
+	 * @param workers Number of worker threads (and connections) to start
+	 *
+	 * @return Pointer to a new ftp_transfer_queue_t on success, NULL on failure
+	 *
+	 * @note All queue functions are thread-safe.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_transfer_queue_t *queue = ftp_transfer_queue_create(client, 8);
+	 * ftp_transfer_queue_submit(queue, FTP_JOB_UPLOAD, "a.csv", "/in/a.csv");
+	 * ftp_transfer_queue_submit(queue, FTP_JOB_UPLOAD, "b.csv", "/in/b.csv");
+	 * ftp_transfer_queue_wait(queue);
+	 * ftp_transfer_queue_destroy(queue);
+	 * @endcode
+	 */
+	ftp_transfer_queue_t *ftp_transfer_queue_create(const ftp_client_t *prototype, int workers);
+
+	/**
+	 * @brief Submit an upload or download job to the queue
+	 *
+	 * @param queue Pointer to the transfer queue
+	 * @param type FTP_JOB_UPLOAD or FTP_JOB_DOWNLOAD
+	 * @param local_path Local source (upload) or destination (download) path
+	 * @param remote_path Remote destination (upload) or source (download) path
+	 *
+	 * @return Job identifier (>= 0) on success
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *
+	 * @note Job identifiers are assigned sequentially from 0.
+	 */
+	long ftp_transfer_queue_submit(ftp_transfer_queue_t *queue, ftp_job_type_t type, const char *local_path,
+								   const char *remote_path);
+
+	/**
+	 * @brief Wait until every submitted job has finished
+	 *
+	 * @param queue Pointer to the transfer queue
+	 *
+	 * @return FTP_OK (0) if all jobs succeeded
+	 *         FTP_ERROR_TRANSFER (-4) if at least one job failed
+	 *         FTP_ERROR_INVALID_PARAM (-7) if queue is NULL
+	 *
+	 * @note Jobs submitted while waiting are included. Use
+	 *       ftp_transfer_queue_get_job_status() to find out which jobs failed.
+	 */
+	int ftp_transfer_queue_wait(ftp_transfer_queue_t *queue);
+
+	/**
+	 * @brief Get the status of a single job
+	 *
+	 * @param queue Pointer to the transfer queue
+	 * @param job_id Identifier returned by ftp_transfer_queue_submit()
+	 * @param status Pointer to receive the job status
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) for an unknown job
+	 *
+	 * Example:
+	 * @code
+	 * ftp_job_status_t status;
+	 * if (ftp_transfer_queue_get_job_status(queue, id, &status) == FTP_OK &&
+	 *     status.state == FTP_JOB_FAILED) {
+	 *     fprintf(stderr, "Job %ld failed: %s\n", id, status.error);
+	 * }
+	 * @endcode
+	 */
+	int ftp_transfer_queue_get_job_status(ftp_transfer_queue_t *queue, long job_id, ftp_job_status_t *status);
+
+	/**
+	 * @brief Get aggregate statistics of the queue
+	 *
+	 * @param queue Pointer to the transfer queue
+	 * @param stats Pointer to receive the statistics
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 *
+	 * @note elapsed is measured from the first submission to the latest job
+	 *       completion; bytes_per_second is bytes divided by elapsed.
+	 */
+	int ftp_transfer_queue_get_stats(ftp_transfer_queue_t *queue, ftp_queue_stats_t *stats);
+
+	/**
+	 * @brief Stop the workers and destroy the queue
+	 *
+	 * Jobs that are still pending are not started. Running jobs finish first.
+	 *
+	 * @param queue Pointer to the transfer queue (NULL is ignored)
+	 *
+	 * @note Call ftp_transfer_queue_wait() first to complete all jobs.
+	 */
+	void ftp_transfer_queue_destroy(ftp_transfer_queue_t *queue);
+
+	/**
+	 * @brief Create an asynchronous transfer engine
+	 *
+	 * Creates an engine that runs many transfers concurrently in the calling thread
+	 * on top of libcurl's multi interface. Requests are started with ftp_async_upload(),
+	 * ftp_async_download() and ftp_async_list(), and progress is driven by
+	 * ftp_async_poll() or ftp_async_run(), which invoke completion callbacks.
+	 *
+	 * @param prototype Configured client whose settings every request copies
+	 * @param max_connections Maximum number of simultaneous connections (0 = unlimited).
+	 *                        Requests beyond the limit wait for a free connection.
+	 *
+	 * @return Pointer to a new ftp_async_t on success, NULL on failure
+	 *
+	 * @note An engine is NOT thread-safe; drive it from a single thread.
+	 *       Connections are kept open and reused between requests.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_async_t *async = ftp_async_create(client, 32);
+	 * @endcode
+	 */
+	ftp_async_t *ftp_async_create(const ftp_client_t *prototype, size_t max_connections);
+
+	/**
+	 * @brief Start an asynchronous upload
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 * @param local_path Path to the local file to upload
+	 * @param remote_path Destination path on the FTP server
+	 * @param callback Function called when the request completes (may be NULL)
+	 * @param user_data User-defined pointer passed to the callback
+	 *
+	 * @return Request handle on success, NULL if the request could not be started
+	 *
+	 * @note The request handle stays valid until its callback returns.
+	 *       The callback receives the same error codes as ftp_client_upload().
+	 *
+	 * Example:
+	 * @code
+	 * void on_done(void *user_data, ftp_async_request_t *request, int result) {
+	 *     if (result != FTP_OK) {
+	 *         fprintf(stderr, "Upload failed: %s\n", ftp_async_request_get_error(request));
+	 *     }
+	 * }
+	 *
+	 * ftp_async_upload(async, "a.txt", "/in/a.txt", on_done, NULL);
+	 * ftp_async_run(async);
+	 * @endcode
+	 */
+	ftp_async_request_t *ftp_async_upload(ftp_async_t *async, const char *local_path, const char *remote_path,
+										  ftp_async_callback_t callback, void *user_data);
+
+	/**
+	 * @brief Start an asynchronous download
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 * @param remote_path Path to the file on the FTP server
+	 * @param local_path Destination path on the local filesystem
+	 * @param callback Function called when the request completes (may be NULL)
+	 * @param user_data User-defined pointer passed to the callback
+	 *
+	 * @return Request handle on success, NULL if the request could not be started
+	 *
+	 * @note The request handle stays valid until its callback returns.
+	 *       Partial files are deleted if the download fails.
+	 */
+	ftp_async_request_t *ftp_async_download(ftp_async_t *async, const char *remote_path, const char *local_path,
+											ftp_async_callback_t callback, void *user_data);
+
+	/**
+	 * @brief Start an asynchronous directory listing
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 * @param remote_path Path to the directory on the FTP server
+	 * @param callback Function called when the request completes (may be NULL)
+	 * @param user_data User-defined pointer passed to the callback
+	 *
+	 * @return Request handle on success, NULL if the request could not be started
+	 *
+	 * @note Inside the callback, ftp_async_request_get_data() returns the listing.
+	 *
+	 * Example:
+	 * @code
+	 * void on_list(void *user_data, ftp_async_request_t *request, int result) {
+	 *     if (result == FTP_OK) {
+	 *         printf("%s\n", ftp_async_request_get_data(request, NULL));
+	 *     }
+	 * }
+	 *
+	 * ftp_async_list(async, "/incoming", on_list, NULL);
+	 * @endcode
+	 */
+	ftp_async_request_t *ftp_async_list(ftp_async_t *async, const char *remote_path, ftp_async_callback_t callback,
+										void *user_data);
+
+	/**
+	 * @brief Drive pending asynchronous transfers
+	 *
+	 * Performs any available network I/O, waiting up to timeout_ms for activity,
+	 * and invokes the callbacks of requests that completed.
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 * @param timeout_ms Maximum time to wait for activity in milliseconds (0 = don't wait)
+	 *
+	 * @return Number of requests still in progress, or a negative error code
+	 *         (FTP_ERROR_INVALID_PARAM, FTP_ERROR_CURL) on failure
+	 *
+	 * @note Callbacks may start new requests.
+	 *
+	 * Example:
+	 * @code
+	 * while (ftp_async_poll(async, 100) > 0) {
+	 *     // Do other work between polls
+	 * }
+	 * @endcode
+	 */
+	int ftp_async_poll(ftp_async_t *async, int timeout_ms);
+
+	/**
+	 * @brief Run until all asynchronous requests have completed
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 *
+	 * @return FTP_OK (0) once no requests remain, or FTP_ERROR_CURL (-8) on engine failure
+	 *
+	 * @note Individual request results are delivered to their callbacks.
+	 */
+	int ftp_async_run(ftp_async_t *async);
+
+	/**
+	 * @brief Cancel an asynchronous request
+	 *
+	 * Stops the request immediately and invokes its callback with FTP_ERROR_TRANSFER.
+	 *
+	 * @param async Pointer to the asynchronous engine
+	 * @param request Request handle that has not completed yet
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 */
+	int ftp_async_cancel(ftp_async_t *async, ftp_async_request_t *request);
+
+	/**
+	 * @brief Get the error message of a completed request
+	 *
+	 * @param request Request handle passed to the completion callback
+	 *
+	 * @return Pointer to the error message (empty on success)
+	 */
+	const char *ftp_async_request_get_error(const ftp_async_request_t *request);
+
+	/**
+	 * @brief Get the data received by a completed listing request
+	 *
+	 * @param request Request handle passed to the completion callback
+	 * @param size Pointer to receive the data size in bytes (may be NULL)
+	 *
+	 * @return Pointer to the NUL-terminated data, or NULL if none was received
+	 *
+	 * @note The data is owned by the request and freed when the callback returns.
+	 */
+	const char *ftp_async_request_get_data(const ftp_async_request_t *request, size_t *size);
+
+	/**
+	 * @brief Get the timing breakdown and byte counts of a completed request
+	 *
+	 * @param request Request handle passed to the completion callback
+	 * @param stats Pointer to receive the statistics (see ftp_client_get_transfer_stats());
+	 *              all fields are 0 for cancelled requests
+	 *
+	 * @return FTP_OK (0) on success, FTP_ERROR_INVALID_PARAM (-7) if any parameter is NULL
+	 */
+	int ftp_async_request_get_transfer_stats(const ftp_async_request_t *request, ftp_transfer_stats_t *stats);
+
+	/**
+	 * @brief Destroy an asynchronous engine
+	 *
+	 * Aborts requests that are still in progress without invoking their callbacks
+	 * and closes all connections.
+	 *
+	 * @param async Pointer to the asynchronous engine (NULL is ignored)
+	 */
+	void ftp_async_destroy(ftp_async_t *async);
+
+	/**
+	 * @brief Initialize recursive walk options with default values
+	 *
+	 * @param options Pointer to the options structure to initialize
+	 *
+	 * @note This function sets:
+	 *       - Workers: 4 parallel sessions
+	 *       - Maximum depth: -1 (unlimited; 0 lists only the root directory)
+	 *       - Pool: NULL (each worker opens its own session)
+	 */
+	void ftp_walk_init_options(ftp_walk_options_t *options);
+
+	/**
+	 * @brief Recursively walk a remote directory tree in parallel
+	 *
+	 * Lists the root directory and all of its subdirectories breadth-first,
+	 * with several sessions listing different directories at the same time.
+	 * Every entry is passed to the visitor as soon as it has been parsed.
+	 *
+	 * @param client Configured client whose settings the workers copy (may be NULL if options->pool is set)
+	 * @param root Directory to start from (NULL for "/")
+	 * @param visitor Function called once per entry
+	 * @param user_data User data passed to the visitor
+	 * @param options Walk options (NULL for defaults)
+	 *
+	 * @return FTP_OK (0) if every directory was listed
+	 *         FTP_ERROR_INVALID_PARAM (-7) if visitor is NULL, or both client and options->pool are NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_CONNECTION (-2) if no worker could obtain a session
+	 *         FTP_ERROR_TRANSFER (-4) if a directory could not be listed or the visitor stopped the walk
+	 *
+	 * @note Visitor calls are serialized, so the visitor needs no locking of its
+	 *       own, but they come from worker threads and in no particular order.
+	 *       Entries of depth 0 are in the root directory. Symbolic links are
+	 *       reported but not followed. A directory that fails to list does not
+	 *       stop the walk; the first failure is returned and its message is
+	 *       stored in client (if not NULL). With options->pool, each worker
+	 *       checks out one session for the duration of the walk, and at most
+	 *       max_sessions workers are started.
+	 *
+	 * Example:
+	 * @code
+	 * static int print_entry(void *user_data, const char *dir_path, const ftp_entry_t *entry, int depth)
+	 * {
+	 *     printf("%s/%s\n", dir_path, entry->name);
+	 *     return 0;  // Continue
+	 * }
+	 *
+	 * ftp_walk_options_t options;
+	 * ftp_walk_init_options(&options);
+	 * options.workers = 8;
+	 * ftp_walk(client, "/archive", print_entry, NULL, &options);
+	 * @endcode
+	 */
+	int ftp_walk(ftp_client_t *client, const char *root, ftp_walk_visitor_t visitor, void *user_data,
+				 const ftp_walk_options_t *options);
+
+	/**
+	 * @brief Initialize directory sync options with default values
+	 *
+	 * @param options Pointer to the options structure to initialize
+	 *
+	 * @note This function sets:
+	 *       - Workers: 4 parallel transfers
+	 *       - Dry run: off
+	 *       - Delete extra: off (files missing from the source are kept)
+	 *       - Compare modification times: on, with 2 seconds tolerance
+	 *       - Callback: none
+	 */
+	void ftp_sync_init_options(ftp_sync_options_t *options);
+
+	/**
+	 * @brief Synchronize a local and a remote directory tree
+	 *
+	 * Scans both trees, plans the directories to create, the files to transfer
+	 * and (with delete_extra) the files and directories to delete, and runs
+	 * the transfers in parallel through an ftp_transfer_queue_t. A file is
+	 * transferred if it is missing on the target, if the sizes differ, or, with
+	 * compare_mtime, if the source is newer than the target by more than
+	 * mtime_tolerance seconds.
+	 *
+	 * @param client Configured client; transfer workers copy its settings
+	 * @param local_dir Local directory
+	 * @param remote_dir Remote directory
+	 * @param direction FTP_SYNC_UPLOAD (local to remote) or FTP_SYNC_DOWNLOAD (remote to local)
+	 * @param options Sync options (NULL for defaults)
+	 * @param stats Pointer to receive the planned action counts, the number of failed
+	 *              actions and the bytes transferred (NULL if not needed)
+	 *
+	 * @return FTP_OK (0) if every planned action succeeded
+	 *         FTP_ERROR_INVALID_PARAM (-7) if any required parameter is NULL
+	 *         FTP_ERROR_MEMORY (-6) if memory allocation fails
+	 *         FTP_ERROR_FILE_IO (-9) if the local directory cannot be read
+	 *         FTP_ERROR_TRANSFER (-4) if the remote tree cannot be listed or an action failed
+	 *
+	 * @note In a dry run nothing is changed; the callback receives every planned
+	 *       action and stats->bytes holds the number of bytes that would be sent.
+	 *       Downloaded files get the remote modification time and uploaded files
+	 *       get a newer one from the server, so an unchanged tree transfers
+	 *       nothing on the next run. Remote times are exact
+	 *       with MLSD; LIST times have minute precision and the server's time zone.
+	 *       Entries that are a file on one side and a directory on the other are
+	 *       counted as conflicts and left alone. Symbolic links are not followed
+	 *       on the remote side; locally, links to files are synced as files and
+	 *       links to directories are skipped.
+	 *
+	 * Example:
+	 * @code
+	 * ftp_sync_options_t options;
+	 * ftp_sync_stats_t stats;
+	 * ftp_sync_init_options(&options);
+	 * options.dry_run = 1;
+	 * ftp_sync(client, "site", "/www", FTP_SYNC_UPLOAD, &options, &stats);
+	 * printf("%zu files, %lld bytes to upload\n", stats.transfers, (long long)stats.bytes);
+	 * @endcode
+	 */
+	int ftp_sync(ftp_client_t *client, const char *local_dir, const char *remote_dir, ftp_sync_direction_t direction,
+				 const ftp_sync_options_t *options, ftp_sync_stats_t *stats);
+
+#ifdef FTP_CLIENT_IMPLEMENTATION
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FTP_HAVE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FTP_HAVE_SSE2
+#endif
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#include <nmmintrin.h>
+#define FTP_HAVE_SSE42
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define FTP_HAVE_ARM_CRC32
+#endif
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+	/* Internal threading primitives */
+
+#ifdef _WIN32
+	typedef CRITICAL_SECTION ftp_mutex_t;
+	typedef CONDITION_VARIABLE ftp_cond_t;
+	typedef HANDLE ftp_thread_t;
+	typedef unsigned(__stdcall *ftp_thread_proc_t)(void *arg);
+#define FTP_THREAD_PROC(name) unsigned __stdcall name(void *arg)
+#define FTP_THREAD_RETURN return 0
+#else
+	typedef pthread_mutex_t ftp_mutex_t;
+	typedef pthread_cond_t ftp_cond_t;
+	typedef pthread_t ftp_thread_t;
+	typedef void *(*ftp_thread_proc_t)(void *arg);
+#define FTP_THREAD_PROC(name) void *name(void *arg)
+#define FTP_THREAD_RETURN return NULL
+#endif
+
+	static int ftp_thread_create(ftp_thread_t *thread, ftp_thread_proc_t proc, void *arg)
+	{
+#ifdef _WIN32
+		*thread = (HANDLE)_beginthreadex(NULL, 0, proc, arg, 0, NULL);
+		return *thread ? 0 : -1;
+#else
+		return pthread_create(thread, NULL, proc, arg) == 0 ? 0 : -1;
+#endif
+	}
+
+	static void ftp_thread_join(ftp_thread_t thread)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(thread, INFINITE);
+		CloseHandle(thread);
+#else
+		pthread_join(thread, NULL);
+#endif
+	}
+
+	static void ftp_mutex_init(ftp_mutex_t *mutex)
+	{
+#ifdef _WIN32
+		InitializeCriticalSection(mutex);
+#else
+		pthread_mutex_init(mutex, NULL);
+#endif
+	}
+
+	static void ftp_mutex_lock(ftp_mutex_t *mutex)
+	{
+#ifdef _WIN32
+		EnterCriticalSection(mutex);
+#else
+		pthread_mutex_lock(mutex);
+#endif
+	}
+
+	static void ftp_mutex_unlock(ftp_mutex_t *mutex)
+	{
+#ifdef _WIN32
+		LeaveCriticalSection(mutex);
+#else
+		pthread_mutex_unlock(mutex);
+#endif
+	}
+
+	static void ftp_mutex_destroy(ftp_mutex_t *mutex)
+	{
+#ifdef _WIN32
+		DeleteCriticalSection(mutex);
+#else
+		pthread_mutex_destroy(mutex);
+#endif
+	}
+
+	static void ftp_cond_init(ftp_cond_t *cond)
+	{
+#ifdef _WIN32
+		InitializeConditionVariable(cond);
+#else
+		pthread_cond_init(cond, NULL);
+#endif
+	}
+
+	static void ftp_cond_wait(ftp_cond_t *cond, ftp_mutex_t *mutex)
+	{
+#ifdef _WIN32
+		SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+		pthread_cond_wait(cond, mutex);
+#endif
+	}
+
+	/* Returns 0 when signalled, non-zero when the timeout expired */
+	static int ftp_cond_timedwait(ftp_cond_t *cond, ftp_mutex_t *mutex, long timeout_ms)
+	{
+#ifdef _WIN32
+		return SleepConditionVariableCS(cond, mutex, (DWORD)timeout_ms) ? 0 : 1;
+#else
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		return pthread_cond_timedwait(cond, mutex, &deadline) == 0 ? 0 : 1;
+#endif
+	}
+
+	static void ftp_cond_signal(ftp_cond_t *cond)
+	{
+#ifdef _WIN32
+		WakeConditionVariable(cond);
+#else
+		pthread_cond_signal(cond);
+#endif
+	}
+
+	static void ftp_cond_broadcast(ftp_cond_t *cond)
+	{
+#ifdef _WIN32
+		WakeAllConditionVariable(cond);
+#else
+		pthread_cond_broadcast(cond);
+#endif
+	}
+
+	static void ftp_cond_destroy(ftp_cond_t *cond)
+	{
+#ifdef _WIN32
+		(void)cond;
+#else
+		pthread_cond_destroy(cond);
+#endif
+	}
+
+	/* Internal file primitives */
+
+	static int ftp_file_open(const char *path, int flags)
+	{
+#ifdef _WIN32
+		return _open(path, flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		return open(path, flags, 0666);
+#endif
+	}
+
+	static int ftp_file_close(int fd)
+	{
+#ifdef _WIN32
+		return _close(fd);
+#else
+		return close(fd);
+#endif
+	}
+
+	static int ftp_file_truncate(int fd, int64_t size)
+	{
+#ifdef _WIN32
+		return _chsize_s(fd, size) == 0 ? 0 : -1;
+#else
+		return ftruncate(fd, (off_t)size);
+#endif
+	}
+
+	/* Write the whole buffer at an absolute offset without moving a shared file position */
+	static int ftp_file_pwrite(int fd, const void *data, size_t size, int64_t offset)
+	{
+		const char *p = (const char *)data;
+
+		while (size > 0)
+		{
+#ifdef _WIN32
+			OVERLAPPED overlapped = {0};
+			DWORD written = 0;
+			overlapped.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFFu);
+			overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+			DWORD chunk = size > 0x40000000u ? 0x40000000u : (DWORD)size;
+			if (!WriteFile((HANDLE)_get_osfhandle(fd), p, chunk, &written, &overlapped) || written == 0)
+			{
+				return -1;
+			}
+#else
+			ssize_t written = pwrite(fd, p, size, (off_t)offset);
+			if (written <= 0)
+			{
+				return -1;
+			}
+#endif
+			p += written;
+			size -= (size_t)written;
+			offset += written;
+		}
+		return 0;
+	}
+
+	static int ftp_dir_create(const char *path)
+	{
+#ifdef _WIN32
+		return _mkdir(path);
+#else
+		return mkdir(path, 0777);
+#endif
+	}
+
+	static int ftp_dir_remove(const char *path)
+	{
+#ifdef _WIN32
+		return _rmdir(path);
+#else
+		return rmdir(path);
+#endif
+	}
+
+	/* Set the access and modification time of a file (seconds since the Unix epoch) */
+	static int ftp_file_set_mtime(const char *path, int64_t mtime)
+	{
+#ifdef _WIN32
+		struct _utimbuf times;
+		times.actime = (time_t)mtime;
+		times.modtime = (time_t)mtime;
+		return _utime(path, &times);
+#else
+		struct utimbuf times;
+		times.actime = (time_t)mtime;
+		times.modtime = (time_t)mtime;
+		return utime(path, &times);
+#endif
+	}
+
+	/* Give a stdio stream a buffer of the configured size and a sequential access hint.
+	   Returns the buffer to free after fclose(), or NULL if the default buffer is kept. */
+	static char *ftp_file_prepare_stream(FILE *fp, size_t buffer_size)
+	{
+#if defined(POSIX_FADV_SEQUENTIAL) && !defined(_WIN32)
+		posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		if (buffer_size == 0)
+		{
+			return NULL;
+		}
+
+		/* A caller-owned buffer, since some C libraries ignore the size of a NULL one */
+		char *buffer = (char *)malloc(buffer_size);
+		if (buffer && setvbuf(fp, buffer, _IOFBF, buffer_size) != 0)
+		{
+			free(buffer);
+			buffer = NULL;
+		}
+		return buffer;
+	}
+
+	static int ftp_stream_fd(FILE *fp)
+	{
+#ifdef _WIN32
+		return _fileno(fp);
+#else
+		return fileno(fp);
+#endif
+	}
+
+	static int ftp_file_sync(int fd)
+	{
+#ifdef _WIN32
+		return _commit(fd);
+#else
+		return fsync(fd);
+#endif
+	}
+
+	/* Flush the directory entry of a file so a rename into it is durable */
+	static int ftp_dir_sync(const char *file_path)
+	{
+#ifdef _WIN32
+		(void)file_path;
+		return 0;
+#else
+		const char *slash = strrchr(file_path, '/');
+		size_t dir_len = slash ? (size_t)(slash - file_path) : 0;
+		char *dir_path = (char *)malloc(dir_len + 2);
+		if (!dir_path)
+		{
+			return -1;
+		}
+		if (!slash)
+		{
+			strcpy(dir_path, ".");
+		}
+		else
+		{
+			memcpy(dir_path, file_path, dir_len ? dir_len : 1);
+			dir_path[dir_len ? dir_len : 1] = '\0';
+		}
+
+		int fd = open(dir_path, O_RDONLY);
+		free(dir_path);
+		if (fd < 0)
+		{
+			return -1;
+		}
+		int result = fsync(fd);
+		close(fd);
+		return result;
+#endif
+	}
+
+	/* Create a new hidden file ".<name>.XXXXXX" next to path; *temp_path receives its name */
+	static FILE *ftp_file_create_temp(const char *path, char **temp_path)
+	{
+		static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+		const char *name = strrchr(path, '/');
+#ifdef _WIN32
+		const char *backslash = strrchr(path, '\\');
+		if (backslash && (!name || backslash > name))
+		{
+			name = backslash;
+		}
+		unsigned long seed = (unsigned long)_getpid();
+#else
+		unsigned long seed = (unsigned long)getpid();
+#endif
+		name = name ? name + 1 : path;
+		size_t dir_len = (size_t)(name - path);
+		size_t name_len = strlen(name);
+
+		char *temp = (char *)malloc(dir_len + name_len + 9);
+		if (!temp)
+		{
+			return NULL;
+		}
+		memcpy(temp, path, dir_len);
+		temp[dir_len] = '.';
+		memcpy(temp + dir_len + 1, name, name_len);
+		temp[dir_len + 1 + name_len] = '.';
+		char *suffix = temp + dir_len + name_len + 2;
+		suffix[6] = '\0';
+
+		/* O_EXCL settles races; the seed only makes collisions unlikely */
+		seed = seed * 2654435761u + (unsigned long)time(NULL) + (unsigned long)(uintptr_t)temp;
+		for (int attempt = 0; attempt < 100; attempt++)
+		{
+			unsigned long value = seed + (unsigned long)attempt * 40503u;
+			for (int i = 0; i < 6; i++)
+			{
+				suffix[i] = digits[value % 36];
+				value /= 36;
+			}
+
+			int fd = ftp_file_open(temp, O_WRONLY | O_CREAT | O_EXCL);
+			if (fd >= 0)
+			{
+#ifdef _WIN32
+				FILE *fp = _fdopen(fd, "wb");
+#else
+				FILE *fp = fdopen(fd, "wb");
+#endif
+				if (!fp)
+				{
+					ftp_file_close(fd);
+					remove(temp);
+					break;
+				}
+				*temp_path = temp;
+				return fp;
+			}
+			if (errno != EEXIST)
+			{
+				break;
+			}
+		}
+		free(temp);
+		return NULL;
+	}
+
+	/* Reserve disk space for a file; returns 0 on success, -2 if the disk is full, -1 if unsupported */
+	static int ftp_file_preallocate(int fd, int64_t size)
+	{
+#ifdef _WIN32
+		FILE_ALLOCATION_INFO info;
+		info.AllocationSize.QuadPart = size;
+		if (SetFileInformationByHandle((HANDLE)_get_osfhandle(fd), FileAllocationInfo, &info, sizeof(info)))
+		{
+			return 0;
+		}
+		DWORD error = GetLastError();
+		return error == ERROR_DISK_FULL || error == ERROR_HANDLE_DISK_FULL ? -2 : -1;
+#elif defined(__APPLE__)
+		fstore_t store;
+		memset(&store, 0, sizeof(store));
+		store.fst_flags = F_ALLOCATECONTIG;
+		store.fst_posmode = F_PEOFPOSMODE;
+		store.fst_length = (off_t)size;
+		if (fcntl(fd, F_PREALLOCATE, &store) == 0)
+		{
+			return 0;
+		}
+		store.fst_flags = F_ALLOCATEALL; /* Contiguous space is not available; take any */
+		if (fcntl(fd, F_PREALLOCATE, &store) == 0)
+		{
+			return 0;
+		}
+		return errno == ENOSPC ? -2 : -1;
+#else
+		int error = posix_fallocate(fd, 0, (off_t)size);
+		return error == 0 ? 0 : (error == ENOSPC || error == EFBIG ? -2 : -1);
+#endif
+	}
+
+	/* Read-only view of a whole file */
+	typedef struct
+	{
+		const char *data;
+		size_t size;
+#ifdef _WIN32
+		HANDLE mapping;
+#endif
+	} ftp_file_map_t;
+
+	/* Map a file for sequential reading; fails for empty files and anything that is not a regular file */
+	static int ftp_file_map(const char *path, ftp_file_map_t *map)
+	{
+		memset(map, 0, sizeof(*map));
+
+		int fd = ftp_file_open(path, O_RDONLY);
+		if (fd < 0)
+		{
+			return -1;
+		}
+
+#ifdef _WIN32
+		HANDLE file = (HANDLE)_get_osfhandle(fd);
+		LARGE_INTEGER size;
+		if (file == INVALID_HANDLE_VALUE || GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) ||
+			size.QuadPart <= 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+		{
+			ftp_file_close(fd);
+			return -1;
+		}
+
+		map->mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		ftp_file_close(fd);
+		if (!map->mapping)
+		{
+			return -1;
+		}
+		map->data = (const char *)MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!map->data)
+		{
+			CloseHandle(map->mapping);
+			map->mapping = NULL;
+			return -1;
+		}
+		map->size = (size_t)size.QuadPart;
+#else
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 ||
+			(uint64_t)info.st_size > (uint64_t)SIZE_MAX)
+		{
+			ftp_file_close(fd);
+			return -1;
+		}
+
+		void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		ftp_file_close(fd);
+		if (data == MAP_FAILED)
+		{
+			return -1;
+		}
+#ifdef MADV_SEQUENTIAL
+		madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+#endif
+		map->data = (const char *)data;
+		map->size = (size_t)info.st_size;
+#endif
+		return 0;
+	}
+
+	static void ftp_file_unmap(ftp_file_map_t *map)
+	{
+		if (map->data)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(map->data);
+			CloseHandle(map->mapping);
+#else
+			munmap((void *)map->data, map->size);
+#endif
+			map->data = NULL;
+		}
+	}
+
+	/* Monotonic clock in milliseconds */
+	static int64_t ftp_time_ms(void)
+	{
+#ifdef _WIN32
+		return (int64_t)GetTickCount64();
+#else
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+	}
+
+	static void ftp_sleep_ms(int64_t milliseconds)
+	{
+#ifdef _WIN32
+		Sleep((DWORD)milliseconds);
+#else
+		struct timespec delay;
+		delay.tv_sec = (time_t)(milliseconds / 1000);
+		delay.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+		while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+		{
+		}
+#endif
+	}
+
+	/* Transfer checksums */
+
+	static uint32_t crc32c_update(uint32_t crc, const unsigned char *data, size_t size)
+	{
+		crc = ~crc;
+#if defined(FTP_HAVE_SSE42)
+#if defined(__x86_64__) || defined(_M_X64)
+		while (size >= 8)
+		{
+			uint64_t word;
+			memcpy(&word, data, 8);
+			crc = (uint32_t)_mm_crc32_u64(crc, word);
+			data += 8;
+			size -= 8;
+		}
+#else
+		while (size >= 4)
+		{
+			uint32_t word;
+			memcpy(&word, data, 4);
+			crc = _mm_crc32_u32(crc, word);
+			data += 4;
+			size -= 4;
+		}
+#endif
+		while (size--)
+		{
+			crc = _mm_crc32_u8(crc, *data++);
+		}
+#elif defined(FTP_HAVE_ARM_CRC32)
+		while (size >= 8)
+		{
+			uint64_t word;
+			memcpy(&word, data, 8);
+			crc = __crc32cd(crc, word);
+			data += 8;
+			size -= 8;
+		}
+		while (size--)
+		{
+			crc = __crc32cb(crc, *data++);
+		}
+#else
+		/* Reflected Castagnoli polynomial 0x82F63B78 */
+		static const uint32_t table[256] = {
+			0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C,
+			0x26A1E7E8, 0xD4CA64EB, 0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
+			0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24, 0x105EC76F, 0xE235446C,
+			0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+			0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC,
+			0xBC267848, 0x4E4DFB4B, 0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A,
+			0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35, 0xAA64D611, 0x580F5512,
+			0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+			0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD,
+			0x1642AE59, 0xE4292D5A, 0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A,
+			0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595, 0x417B1DBC, 0xB3109EBF,
+			0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+			0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F,
+			0xED03A29B, 0x1F682198, 0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927,
+			0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38, 0xDBFC821C, 0x2997011F,
+			0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+			0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E,
+			0x4767748A, 0xB50CF789, 0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859,
+			0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46, 0x7198540D, 0x83F3D70E,
+			0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+			0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE,
+			0xDDE0EB2A, 0x2F8B6829, 0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C,
+			0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93, 0x082F63B7, 0xFA44E0B4,
+			0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+			0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B,
+			0xB4091BFF, 0x466298FC, 0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C,
+			0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033, 0xA24BB5A6, 0x502036A5,
+			0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+			0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975,
+			0x0E330A81, 0xFC588982, 0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D,
+			0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622, 0x38CC2A06, 0xCAA7A905,
+			0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+			0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8,
+			0xE52CC12C, 0x1747422F, 0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF,
+			0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0, 0xD3D3E1AB, 0x21B862A8,
+			0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+			0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78,
+			0x7FAB5E8C, 0x8DC0DD8F, 0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE,
+			0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1, 0x69E9F0D5, 0x9B8273D6,
+			0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+			0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69,
+			0xD5CF889D, 0x27A40B9E, 0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E,
+			0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+		};
+		while (size--)
+		{
+			crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+		}
+#endif
+		return ~crc;
+	}
+
+#define FTP_XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define FTP_XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define FTP_XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define FTP_XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define FTP_XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+	typedef struct
+	{
+		uint64_t lanes[4];
+		uint64_t total;
+		unsigned char buffer[32];
+		size_t buffered;
+	} ftp_xxh64_t;
+
+	static uint64_t xxh64_rotl(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	static uint64_t xxh64_read64(const unsigned char *p)
+	{
+		return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+			   ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+	}
+
+	static uint64_t xxh64_round(uint64_t lane, uint64_t input)
+	{
+		lane += input * FTP_XXH_PRIME64_2;
+		return xxh64_rotl(lane, 31) * FTP_XXH_PRIME64_1;
+	}
+
+	static uint64_t xxh64_merge(uint64_t hash, uint64_t lane)
+	{
+		hash ^= xxh64_round(0, lane);
+		return hash * FTP_XXH_PRIME64_1 + FTP_XXH_PRIME64_4;
+	}
+
+	static void xxh64_init(ftp_xxh64_t *state)
+	{
+		memset(state, 0, sizeof(*state));
+		state->lanes[0] = FTP_XXH_PRIME64_1 + FTP_XXH_PRIME64_2;
+		state->lanes[1] = FTP_XXH_PRIME64_2;
+		state->lanes[2] = 0;
+		state->lanes[3] = 0 - FTP_XXH_PRIME64_1;
+	}
+
+	static void xxh64_update(ftp_xxh64_t *state, const unsigned char *data, size_t size)
+	{
+		state->total += size;
+
+		if (state->buffered + size < 32)
+		{
+			memcpy(state->buffer + state->buffered, data, size);
+			state->buffered += size;
+			return;
+		}
+
+		if (state->buffered > 0)
+		{
+			size_t fill = 32 - state->buffered;
+			memcpy(state->buffer + state->buffered, data, fill);
+			for (int i = 0; i < 4; i++)
+			{
+				state->lanes[i] = xxh64_round(state->lanes[i], xxh64_read64(state->buffer + i * 8));
+			}
+			data += fill;
+			size -= fill;
+			state->buffered = 0;
+		}
+
+		/* Four independent lanes keep the multipliers busy in parallel */
+		uint64_t v1 = state->lanes[0], v2 = state->lanes[1], v3 = state->lanes[2], v4 = state->lanes[3];
+		while (size >= 32)
+		{
+			v1 = xxh64_round(v1, xxh64_read64(data));
+			v2 = xxh64_round(v2, xxh64_read64(data + 8));
+			v3 = xxh64_round(v3, xxh64_read64(data + 16));
+			v4 = xxh64_round(v4, xxh64_read64(data + 24));
+			data += 32;
+			size -= 32;
+		}
+		state->lanes[0] = v1;
+		state->lanes[1] = v2;
+		state->lanes[2] = v3;
+		state->lanes[3] = v4;
+
+		memcpy(state->buffer, data, size);
+		state->buffered = size;
+	}
+
+	static uint64_t xxh64_digest(const ftp_xxh64_t *state)
+	{
+		uint64_t hash;
+		if (state->total >= 32)
+		{
+			hash = xxh64_rotl(state->lanes[0], 1) + xxh64_rotl(state->lanes[1], 7) + xxh64_rotl(state->lanes[2], 12) +
+				   xxh64_rotl(state->lanes[3], 18);
+			for (int i = 0; i < 4; i++)
+			{
+				hash = xxh64_merge(hash, state->lanes[i]);
+			}
+		}
+		else
+		{
+			hash = FTP_XXH_PRIME64_5;
+		}
+		hash += state->total;
+
+		const unsigned char *p = state->buffer;
+		size_t left = state->buffered;
+		while (left >= 8)
+		{
+			hash ^= xxh64_round(0, xxh64_read64(p));
+			hash = xxh64_rotl(hash, 27) * FTP_XXH_PRIME64_1 + FTP_XXH_PRIME64_4;
+			p += 8;
+			left -= 8;
+		}
+		if (left >= 4)
+		{
+			uint64_t word = (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24);
+			hash ^= word * FTP_XXH_PRIME64_1;
+			hash = xxh64_rotl(hash, 23) * FTP_XXH_PRIME64_2 + FTP_XXH_PRIME64_3;
+			p += 4;
+			left -= 4;
+		}
+		while (left--)
+		{
+			hash ^= (uint64_t)*p++ * FTP_XXH_PRIME64_5;
+			hash = xxh64_rotl(hash, 11) * FTP_XXH_PRIME64_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= FTP_XXH_PRIME64_2;
+		hash ^= hash >> 29;
+		hash *= FTP_XXH_PRIME64_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	typedef struct
+	{
+		uint32_t state[8];
+		uint64_t total;
+		unsigned char buffer[64];
+		size_t buffered;
+	} ftp_sha256_t;
+
+#define FTP_SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+	static void sha256_init(ftp_sha256_t *sha)
+	{
+		static const uint32_t initial[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+											0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+		memcpy(sha->state, initial, sizeof(initial));
+		sha->total = 0;
+		sha->buffered = 0;
+	}
+
+	static void sha256_block(uint32_t *state, const unsigned char *block)
+	{
+		static const uint32_t k[64] = {
+			0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+			0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+			0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+			0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+			0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+			0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+			0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+			0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
+
+		uint32_t w[64];
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+				   ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+		}
+		for (int i = 16; i < 64; i++)
+		{
+			uint32_t s0 = FTP_SHA256_ROTR(w[i - 15], 7) ^ FTP_SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			uint32_t s1 = FTP_SHA256_ROTR(w[i - 2], 17) ^ FTP_SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+		for (int i = 0; i < 64; i++)
+		{
+			uint32_t s1 = FTP_SHA256_ROTR(e, 6) ^ FTP_SHA256_ROTR(e, 11) ^ FTP_SHA256_ROTR(e, 25);
+			uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + k[i] + w[i];
+			uint32_t s0 = FTP_SHA256_ROTR(a, 2) ^ FTP_SHA256_ROTR(a, 13) ^ FTP_SHA256_ROTR(a, 22);
+			uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+
+	static void sha256_update(ftp_sha256_t *sha, const unsigned char *data, size_t size)
+	{
+		sha->total += size;
+
+		if (sha->buffered > 0)
+		{
+			size_t fill = 64 - sha->buffered;
+			if (fill > size)
+			{
+				fill = size;
+			}
+			memcpy(sha->buffer + sha->buffered, data, fill);
+			sha->buffered += fill;
+			data += fill;
+			size -= fill;
+			if (sha->buffered < 64)
+			{
+				return;
+			}
+			sha256_block(sha->state, sha->buffer);
+			sha->buffered = 0;
+		}
+
+		while (size >= 64)
+		{
+			sha256_block(sha->state, data);
+			data += 64;
+			size -= 64;
+		}
+
+		memcpy(sha->buffer, data, size);
+		sha->buffered = size;
+	}
+
+	static void sha256_digest(const ftp_sha256_t *sha, unsigned char digest[32])
+	{
+		ftp_sha256_t last = *sha;
+		uint64_t bits = sha->total * 8;
+
+		unsigned char padding[72];
+		size_t pad_len = (last.buffered < 56 ? 56 : 120) - last.buffered;
+		memset(padding, 0, sizeof(padding));
+		padding[0] = 0x80;
+		for (int i = 0; i < 8; i++)
+		{
+			padding[pad_len + (size_t)i] = (unsigned char)(bits >> (56 - i * 8));
+		}
+		sha256_update(&last, padding, pad_len + 8);
+
+		for (int i = 0; i < 8; i++)
+		{
+			digest[i * 4] = (unsigned char)(last.state[i] >> 24);
+			digest[i * 4 + 1] = (unsigned char)(last.state[i] >> 16);
+			digest[i * 4 + 2] = (unsigned char)(last.state[i] >> 8);
+			digest[i * 4 + 3] = (unsigned char)last.state[i];
+		}
+	}
+
+	/* Checksums of the data passing through the current transfer's read or write callback */
+	struct ftp_checksum_state
+	{
+		unsigned int types;
+		int64_t bytes;
+		uint32_t crc32c;
+		ftp_xxh64_t xxh64;
+		ftp_sha256_t sha256;
+
+		size_t (*callback)(void *, size_t, size_t, void *);
+		void *callback_data;
+	};
+
+	static void checksum_update(struct ftp_checksum_state *state, const void *data, size_t size)
+	{
+		const unsigned char *bytes = (const unsigned char *)data;
+		state->bytes += (int64_t)size;
+		if (state->types & FTP_CHECKSUM_CRC32C)
+		{
+			state->crc32c = crc32c_update(state->crc32c, bytes, size);
+		}
+		if (state->types & FTP_CHECKSUM_XXH64)
+		{
+			xxh64_update(&state->xxh64, bytes, size);
+		}
+		if (state->types & FTP_CHECKSUM_SHA256)
+		{
+			sha256_update(&state->sha256, bytes, size);
+		}
+	}
+
+	static size_t checksum_read_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_checksum_state *state = (struct ftp_checksum_state *)stream;
+		size_t count = state->callback(ptr, size, nmemb, state->callback_data);
+		if (count <= size * nmemb)
+		{
+			checksum_update(state, ptr, count);
+		}
+		return count;
+	}
+
+	static size_t checksum_write_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_checksum_state *state = (struct ftp_checksum_state *)stream;
+		size_t count = state->callback(ptr, size, nmemb, state->callback_data);
+		if (count == size * nmemb)
+		{
+			checksum_update(state, ptr, count); /* Paused or failed blocks are not consumed */
+		}
+		return count;
+	}
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+	/* MODE Z transfers: a zlib stream on the data connection, inflated or deflated in the data callbacks */
+#define FTP_ZLIB_CHUNK 65536
+
+	struct ftp_compression_state
+	{
+		int requested; /* Set when the current transfer may be compressed */
+		int stale;	   /* A failed compressed transfer may have left the connection in MODE Z */
+		z_stream deflater;
+		z_stream inflater;
+		int deflater_ready;
+		int inflater_ready;
+		int input_done;
+		int finished;
+		int truncated; /* The download ended before the end of the zlib stream */
+		unsigned char *buffer; /* Upload input or download output, FTP_ZLIB_CHUNK bytes */
+		size_t pending;		   /* Inflated bytes a paused consumer has not taken yet */
+		size_t skip;		   /* Bytes at the start of redelivered input that were already inflated */
+		struct curl_slist *mode_z;
+		struct curl_slist *mode_s;
+		ftp_compression_stats_t stats;
+
+		size_t (*callback)(void *, size_t, size_t, void *);
+		void *callback_data;
+	};
+
+	static struct ftp_compression_state *compression_state_create(void)
+	{
+		struct ftp_compression_state *state =
+			(struct ftp_compression_state *)calloc(1, sizeof(struct ftp_compression_state));
+		if (!state)
+		{
+			return NULL;
+		}
+
+		state->buffer = (unsigned char *)malloc(FTP_ZLIB_CHUNK);
+		state->mode_z = curl_slist_append(NULL, "MODE Z");
+		state->mode_s = curl_slist_append(NULL, "MODE S");
+		if (!state->buffer || !state->mode_z || !state->mode_s)
+		{
+			free(state->buffer);
+			curl_slist_free_all(state->mode_z);
+			curl_slist_free_all(state->mode_s);
+			free(state);
+			return NULL;
+		}
+		return state;
+	}
+
+	static void compression_state_destroy(struct ftp_compression_state *state)
+	{
+		if (state)
+		{
+			if (state->deflater_ready)
+			{
+				deflateEnd(&state->deflater);
+			}
+			if (state->inflater_ready)
+			{
+				inflateEnd(&state->inflater);
+			}
+			free(state->buffer);
+			curl_slist_free_all(state->mode_z);
+			curl_slist_free_all(state->mode_s);
+			free(state);
+		}
+	}
+
+	/* The zlib streams live as long as the client and are reset for every transfer */
+	static int compression_reset(struct ftp_compression_state *state, int upload, int level)
+	{
+		if (upload)
+		{
+			if (!state->deflater_ready)
+			{
+				if (deflateInit(&state->deflater, level) != Z_OK)
+				{
+					return -1;
+				}
+				state->deflater_ready = 1;
+			}
+			else if (deflateReset(&state->deflater) != Z_OK ||
+					 deflateParams(&state->deflater, level, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				return -1;
+			}
+			state->deflater.avail_in = 0;
+		}
+		else
+		{
+			if (!state->inflater_ready)
+			{
+				if (inflateInit(&state->inflater) != Z_OK)
+				{
+					return -1;
+				}
+				state->inflater_ready = 1;
+			}
+			else if (inflateReset(&state->inflater) != Z_OK)
+			{
+				return -1;
+			}
+		}
+
+		state->input_done = 0;
+		state->finished = 0;
+		state->pending = 0;
+		state->skip = 0;
+		return 0;
+	}
+
+	static size_t deflate_read_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_compression_state *state = (struct ftp_compression_state *)stream;
+		z_stream *z = &state->deflater;
+		size_t capacity = size * nmemb;
+
+		z->next_out = (Bytef *)ptr;
+		z->avail_out = (uInt)capacity;
+		while (z->avail_out > 0 && !state->finished)
+		{
+			if (z->avail_in == 0 && !state->input_done)
+			{
+				size_t count = state->callback(state->buffer, 1, FTP_ZLIB_CHUNK, state->callback_data);
+				if (count == CURL_READFUNC_PAUSE)
+				{
+					if (z->avail_out < capacity)
+					{
+						break; /* Send what is already compressed */
+					}
+					return CURL_READFUNC_PAUSE;
+				}
+				if (count > FTP_ZLIB_CHUNK)
+				{
+					return CURL_READFUNC_ABORT;
+				}
+				state->input_done = count == 0;
+				state->stats.raw_bytes += (int64_t)count;
+				z->next_in = state->buffer;
+				z->avail_in = (uInt)count;
+			}
+
+			int ret = deflate(z, state->input_done ? Z_FINISH : Z_NO_FLUSH);
+			if (ret == Z_STREAM_END)
+			{
+				state->finished = 1;
+			}
+			else if (ret != Z_OK && ret != Z_BUF_ERROR)
+			{
+				return CURL_READFUNC_ABORT;
+			}
+		}
+
+		size_t produced = capacity - z->avail_out;
+		state->stats.wire_bytes += (int64_t)produced;
+		return produced;
+	}
+
+	static size_t inflate_write_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_compression_state *state = (struct ftp_compression_state *)stream;
+		z_stream *z = &state->inflater;
+		size_t total = size * nmemb;
+
+		/* After a pause the consumer gets the leftover output first, then curl repeats the paused input */
+		if (state->pending > 0)
+		{
+			size_t count = state->callback(state->buffer, 1, state->pending, state->callback_data);
+			if (count == CURL_WRITEFUNC_PAUSE)
+			{
+				return CURL_WRITEFUNC_PAUSE;
+			}
+			if (count != state->pending)
+			{
+				return 0;
+			}
+			state->stats.raw_bytes += (int64_t)count;
+			state->pending = 0;
+		}
+
+		size_t start = state->skip < total ? state->skip : total;
+		state->skip -= start;
+		state->stats.wire_bytes += (int64_t)(total - start);
+
+		z->next_in = (Bytef *)ptr + start;
+		z->avail_in = (uInt)(total - start);
+		while (z->avail_in > 0 && !state->finished)
+		{
+			z->next_out = state->buffer;
+			z->avail_out = FTP_ZLIB_CHUNK;
+			int ret = inflate(z, Z_NO_FLUSH);
+			if (ret == Z_STREAM_END)
+			{
+				state->finished = 1;
+			}
+			else if (ret != Z_OK)
+			{
+				return 0; /* Corrupt stream */
+			}
+
+			size_t have = FTP_ZLIB_CHUNK - z->avail_out;
+			if (have == 0)
+			{
+				continue;
+			}
+
+			size_t count = state->callback(state->buffer, 1, have, state->callback_data);
+			if (count == CURL_WRITEFUNC_PAUSE)
+			{
+				state->pending = have;
+				state->skip = total - z->avail_in;
+				state->stats.wire_bytes -= (int64_t)z->avail_in;
+				return CURL_WRITEFUNC_PAUSE;
+			}
+			if (count != have)
+			{
+				return 0;
+			}
+			state->stats.raw_bytes += (int64_t)have;
+		}
+
+		return total;
+	}
+
+	/* Wrap the data callback of a transfer that was cleared for MODE Z by prepare_transfer_handle() */
+	static void compression_wrap(ftp_client_t *client, int upload, size_t (**callback)(void *, size_t, size_t, void *),
+								 void **data)
+	{
+		struct ftp_compression_state *state = client->compression_state;
+		if (!state)
+		{
+			return;
+		}
+
+		memset(&state->stats, 0, sizeof(state->stats));
+		if (!state->requested || compression_reset(state, upload, client->config.compression_level) != 0)
+		{
+			return;
+		}
+
+		state->callback = *callback;
+		state->callback_data = *data;
+		state->stats.compressed = 1;
+		*callback = upload ? deflate_read_callback : inflate_write_callback;
+		*data = state;
+
+		/* Sizes announced by the server and passed to curl count uncompressed bytes */
+		curl_easy_setopt(client->curl, CURLOPT_PREQUOTE, state->mode_z);
+		curl_easy_setopt(client->curl, CURLOPT_POSTQUOTE, state->mode_s);
+		curl_easy_setopt(client->curl, CURLOPT_IGNORE_CONTENT_LENGTH, 1L);
+		if (upload)
+		{
+			curl_easy_setopt(client->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)-1);
+		}
+	}
+#endif
+
+	/* Bandwidth limits: token buckets refilled at the configured rate; transfers may run into debt and then wait */
+#define FTP_RATE_SEND 0
+#define FTP_RATE_RECEIVE 1
+#define FTP_RATE_BURST_MS 250
+
+	typedef struct
+	{
+		int64_t rate;	/* Bytes per second, 0 for unlimited */
+		double tokens;	/* Negative while transfers owe bytes */
+		int64_t updated_ms;
+	} ftp_token_bucket_t;
+
+	struct ftp_rate_limiter
+	{
+		ftp_mutex_t mutex;
+		ftp_token_bucket_t buckets[2]; /* Indexed by FTP_RATE_SEND / FTP_RATE_RECEIVE */
+	};
+
+	/* Per-client caps and the data callback of the running transfer */
+	struct ftp_throttle_state
+	{
+		ftp_rate_limiter_t *own;
+		ftp_client_t *client;
+		size_t (*callback)(void *, size_t, size_t, void *);
+		void *callback_data;
+	};
+
+	static void token_bucket_refill(ftp_token_bucket_t *bucket, int64_t now)
+	{
+		if (bucket->rate > 0 && now > bucket->updated_ms)
+		{
+			double burst = (double)bucket->rate * FTP_RATE_BURST_MS / 1000.0;
+			bucket->tokens += (double)bucket->rate * (double)(now - bucket->updated_ms) / 1000.0;
+			if (bucket->tokens > burst)
+			{
+				bucket->tokens = burst;
+			}
+		}
+		bucket->updated_ms = now;
+	}
+
+	/* Take bytes from a bucket (0 only checks it); returns how long to wait until the debt is paid */
+	static int64_t rate_limiter_take(ftp_rate_limiter_t *limiter, int direction, size_t bytes)
+	{
+		if (!limiter)
+		{
+			return 0;
+		}
+
+		int64_t delay = 0;
+		ftp_token_bucket_t *bucket = &limiter->buckets[direction];
+
+		ftp_mutex_lock(&limiter->mutex);
+		if (bucket->rate > 0)
+		{
+			token_bucket_refill(bucket, ftp_time_ms());
+			bucket->tokens -= (double)bytes;
+			if (bucket->tokens < 0)
+			{
+				delay = (int64_t)(-bucket->tokens * 1000.0 / (double)bucket->rate) + 1;
+			}
+		}
+		ftp_mutex_unlock(&limiter->mutex);
+		return delay;
+	}
+
+	/* Charge a transfer against the client's own caps and its shared limiter */
+	static int64_t client_rate_take(ftp_client_t *client, int direction, size_t bytes)
+	{
+		int64_t own = client->throttle_state ? rate_limiter_take(client->throttle_state->own, direction, bytes) : 0;
+		int64_t shared = rate_limiter_take(client->rate_limiter, direction, bytes);
+		return own > shared ? own : shared;
+	}
+
+	static void client_rate_wait(ftp_client_t *client, int direction, size_t bytes)
+	{
+		int64_t delay = client_rate_take(client, direction, bytes);
+		if (delay > 0)
+		{
+			ftp_sleep_ms(delay);
+		}
+	}
+
+	static int client_rate_limited(const ftp_client_t *client)
+	{
+		return client->rate_limiter || (client->throttle_state && client->throttle_state->own);
+	}
+
+	static size_t throttle_read_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_throttle_state *state = (struct ftp_throttle_state *)stream;
+		size_t count = state->callback(ptr, size, nmemb, state->callback_data);
+		if (count > 0 && count <= size * nmemb)
+		{
+			client_rate_wait(state->client, FTP_RATE_SEND, count);
+		}
+		return count;
+	}
+
+	static size_t throttle_write_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		struct ftp_throttle_state *state = (struct ftp_throttle_state *)stream;
+		size_t count = state->callback(ptr, size, nmemb, state->callback_data);
+		if (count > 0 && count == size * nmemb)
+		{
+			client_rate_wait(state->client, FTP_RATE_RECEIVE, count);
+		}
+		return count;
+	}
+
+	ftp_rate_limiter_t *ftp_rate_limiter_create(int64_t send_rate, int64_t receive_rate)
+	{
+		ftp_rate_limiter_t *limiter = (ftp_rate_limiter_t *)calloc(1, sizeof(ftp_rate_limiter_t));
+		if (!limiter)
+		{
+			return NULL;
+		}
+
+		ftp_mutex_init(&limiter->mutex);
+		ftp_rate_limiter_set_rates(limiter, send_rate, receive_rate);
+		return limiter;
+	}
+
+	void ftp_rate_limiter_set_rates(ftp_rate_limiter_t *limiter, int64_t send_rate, int64_t receive_rate)
+	{
+		if (!limiter)
+		{
+			return;
+		}
+
+		int64_t rates[2];
+		rates[FTP_RATE_SEND] = send_rate > 0 ? send_rate : 0;
+		rates[FTP_RATE_RECEIVE] = receive_rate > 0 ? receive_rate : 0;
+
+		ftp_mutex_lock(&limiter->mutex);
+		int64_t now = ftp_time_ms();
+		for (int i = 0; i < 2; i++)
+		{
+			ftp_token_bucket_t *bucket = &limiter->buckets[i];
+			token_bucket_refill(bucket, now); /* Time so far counts at the old rate */
+			if (rates[i] == 0 || bucket->rate == 0)
+			{
+				bucket->tokens = 0;
+			}
+			else
+			{
+				/* Keep the outstanding wait the same length; a debt run up at a high rate
+				 * must not take minutes to repay at a much lower one */
+				bucket->tokens = bucket->tokens * (double)rates[i] / (double)bucket->rate;
+			}
+			bucket->rate = rates[i];
+		}
+		ftp_mutex_unlock(&limiter->mutex);
+	}
+
+	void ftp_rate_limiter_destroy(ftp_rate_limiter_t *limiter)
+	{
+		if (limiter)
+		{
+			ftp_mutex_destroy(&limiter->mutex);
+			free(limiter);
+		}
+	}
+
+	/* Wrap a data callback in the client's rate limit stage, if any limit applies */
+	static void throttle_wrap(ftp_client_t *client, int upload, size_t (**callback)(void *, size_t, size_t, void *),
+							  void **data)
+	{
+		if (!client_rate_limited(client))
+		{
+			return;
+		}
+
+		struct ftp_throttle_state *throttle = client->throttle_state;
+		if (!throttle)
+		{
+			throttle = client->throttle_state = (struct ftp_throttle_state *)calloc(1, sizeof(struct ftp_throttle_state));
+		}
+		if (throttle)
+		{
+			throttle->client = client;
+			throttle->callback = *callback;
+			throttle->callback_data = *data;
+			*callback = upload ? throttle_read_callback : throttle_write_callback;
+			*data = throttle;
+		}
+	}
+
+	/* Install the write callback of a listing or command reply behind the rate limit only; the
+	 * checksum and compression results keep describing the last upload or download */
+	static void set_reply_callback(ftp_client_t *client, size_t (*callback)(void *, size_t, size_t, void *), void *data)
+	{
+		throttle_wrap(client, 0, &callback, &data);
+		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, callback);
+		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, data);
+	}
+
+	/* Install a transfer's read or write callback behind the enabled checksum, compression and rate limit stages */
+	static void set_transfer_callback(ftp_client_t *client, int upload, size_t (*callback)(void *, size_t, size_t, void *),
+									  void *data)
+	{
+		struct ftp_checksum_state *state = client->checksum_state;
+		if (client->config.checksum_types && !state)
+		{
+			state = client->checksum_state = (struct ftp_checksum_state *)malloc(sizeof(struct ftp_checksum_state));
+		}
+		if (state)
+		{
+			state->types = client->config.checksum_types;
+			state->bytes = 0;
+			state->crc32c = 0;
+			xxh64_init(&state->xxh64);
+			sha256_init(&state->sha256);
+			if (state->types)
+			{
+				state->callback = callback;
+				state->callback_data = data;
+				callback = upload ? checksum_read_callback : checksum_write_callback;
+				data = state;
+			}
+		}
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		compression_wrap(client, upload, &callback, &data);
+#endif
+
+		/* Limits count the bytes on the wire, so they apply after compression */
+		throttle_wrap(client, upload, &callback, &data);
+
+		curl_easy_setopt(client->curl, upload ? CURLOPT_READFUNCTION : CURLOPT_WRITEFUNCTION, callback);
+		curl_easy_setopt(client->curl, upload ? CURLOPT_READDATA : CURLOPT_WRITEDATA, data);
+	}
+
+	/* Internal helper functions */
+
+	static size_t write_memory_callback(void *contents, size_t size, size_t nmemb, void *userp)
+	{
+		size_t realsize = size * nmemb;
+		ftp_memory_buffer_t *mem = (ftp_memory_buffer_t *)userp;
+
+		if (mem->size + realsize + 1 > mem->capacity)
+		{
+			size_t new_capacity = mem->capacity == 0 ? FTP_BUFFER_SIZE : mem->capacity * 2;
+			while (new_capacity < mem->size + realsize + 1)
+			{
+				new_capacity *= 2;
+			}
+
+			char *new_data = (char *)realloc(mem->data, new_capacity);
+			if (!new_data)
+			{
+				return 0;
+			}
+			mem->data = new_data;
+			mem->capacity = new_capacity;
+		}
+
+		memcpy(&(mem->data[mem->size]), contents, realsize);
+		mem->size += realsize;
+		mem->data[mem->size] = 0;
+
+		return realsize;
+	}
+
+	static size_t read_file_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		size_t retcode = fread(ptr, size, nmemb, (FILE *)stream);
+		return retcode;
+	}
+
+	/* In-memory upload source */
+	typedef struct
+	{
+		const char *data;
+		size_t size;
+		size_t offset;
+	} ftp_memory_reader_t;
+
+	static size_t read_memory_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		ftp_memory_reader_t *reader = (ftp_memory_reader_t *)stream;
+		size_t count = size * nmemb;
+		size_t left = reader->size - reader->offset;
+		if (count > left)
+		{
+			count = left;
+		}
+		memcpy(ptr, reader->data + reader->offset, count);
+		reader->offset += count;
+		return count;
+	}
+
+	/* Scatter/gather upload source */
+	typedef struct
+	{
+		const ftp_iovec_t *iov;
+		size_t count;
+		size_t index;
+		size_t offset; /* Within iov[index] */
+	} ftp_iov_reader_t;
+
+	static size_t read_iov_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		ftp_iov_reader_t *reader = (ftp_iov_reader_t *)stream;
+		char *out = (char *)ptr;
+		size_t room = size * nmemb;
+		size_t copied = 0;
+
+		while (copied < room && reader->index < reader->count)
+		{
+			const ftp_iovec_t *segment = &reader->iov[reader->index];
+			size_t count = segment->iov_len - reader->offset;
+			if (count > room - copied)
+			{
+				count = room - copied;
+			}
+			memcpy(out + copied, (const char *)segment->iov_base + reader->offset, count);
+			copied += count;
+			reader->offset += count;
+			if (reader->offset == segment->iov_len)
+			{
+				reader->index++;
+				reader->offset = 0;
+			}
+		}
+		return copied;
+	}
+
+	static size_t write_file_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		size_t written = fwrite(ptr, size, nmemb, (FILE *)stream);
+		return written;
+	}
+
+	/* Keep the regular verbose output while a debug callback is installed */
+	static void echo_verbose_output(const ftp_client_t *client, curl_infotype type, const char *data, size_t size)
+	{
+		static const char prefix[3][3] = {"* ", "< ", "> "};
+		if (client->config.verbose && type <= CURLINFO_HEADER_OUT)
+		{
+			fputs(prefix[type], stderr);
+			fwrite(data, 1, size, stderr);
+		}
+	}
+
+	static int progress_callback_wrapper(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal,
+										 curl_off_t ulnow)
+	{
+		ftp_client_t *client = (ftp_client_t *)clientp;
+		if (client->config.progress_callback)
+		{
+			return client->config.progress_callback(client->config.progress_user_data, (double)dltotal, (double)dlnow,
+													(double)ultotal, (double)ulnow);
+		}
+		return 0;
+	}
+
+	static int socket_address_port(const struct sockaddr *addr)
+	{
+		const unsigned char *port = NULL;
+
+		if (addr->sa_family == AF_INET)
+		{
+			port = (const unsigned char *)&((const struct sockaddr_in *)addr)->sin_port;
+		}
+		else if (addr->sa_family == AF_INET6)
+		{
+			port = (const unsigned char *)&((const struct sockaddr_in6 *)addr)->sin6_port;
+		}
+
+		/* Ports are stored in network byte order */
+		return port ? (port[0] << 8) | port[1] : -1;
+	}
+
+	static curl_socket_t open_socket_callback(void *clientp, curlsocktype purpose, struct curl_sockaddr *address)
+	{
+		ftp_client_t *client = (ftp_client_t *)clientp;
+
+		/* Data connections use server-chosen ports, so only sockets to the
+		 * configured port are new control connections (and new logins) */
+		if (purpose == CURLSOCKTYPE_IPCXN && socket_address_port(&address->addr) == client->config.port)
+		{
+			client->session_stats.connections_opened++;
+		}
+
+		return socket(address->family, address->socktype, address->protocol);
+	}
+
+	/* Determine the size of an open file and rewind it, using 64-bit offsets */
+	static int get_local_file_size(FILE *fp, int64_t *size)
+	{
+#ifdef _MSC_VER
+		/* Windows specific 64-bit functions */
+		if (_fseeki64(fp, 0, SEEK_END) != 0)
+		{
+			return -1;
+		}
+		*size = _ftelli64(fp);
+		if (_fseeki64(fp, 0, SEEK_SET) != 0)
+		{
+			return -1;
+		}
+#else
+		/* POSIX standard 64-bit functions */
+		if (fseeko(fp, 0, SEEK_END) != 0)
+		{
+			return -1;
+		}
+		*size = (int64_t)ftello(fp);
+		if (fseeko(fp, 0, SEEK_SET) != 0)
+		{
+			return -1;
+		}
+#endif
+		return *size < 0 ? -1 : 0;
+	}
+
+	/* Position a file at a 64-bit offset */
+	static int seek_local_file(FILE *fp, int64_t offset)
+	{
+#ifdef _MSC_VER
+		return _fseeki64(fp, offset, SEEK_SET) != 0 ? -1 : 0;
+#else
+		return fseeko(fp, (off_t)offset, SEEK_SET) != 0 ? -1 : 0;
+#endif
+	}
+
+	/* Rename a file, replacing the destination if it exists */
+	static int replace_local_file(const char *from, const char *to)
+	{
+#ifdef _WIN32
+		return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+		return rename(from, to);
+#endif
+	}
+
+	static int build_ftp_url(const ftp_client_t *client, const char *remote_path, char *url, size_t url_size)
+	{
+		const char *protocol = "ftp";
+
+		if (!client->config.host)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		size_t host_len = strlen(client->config.host);
+		if (host_len == 0 || host_len > 255)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		for (size_t i = 0; i < host_len; i++)
+		{
+			char c = client->config.host[i];
+			if (c == '\0' || c == '/' || c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			{
+				return FTP_ERROR_INVALID_PARAM;
+			}
+		}
+
+		size_t base_len = strlen(protocol) + 3 + host_len + 6; /* 6 chars max for port (65535) */
+		size_t path_len = remote_path ? strlen(remote_path) : 0;
+		size_t required_len = base_len + path_len + 1;
+
+		if (required_len > url_size)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		int written;
+		if (remote_path && remote_path[0] == '/')
+		{
+			written = snprintf(url, url_size, "%s://%s:%d%s", protocol, client->config.host, client->config.port, remote_path);
+		}
+		else if (remote_path)
+		{
+			written = snprintf(url, url_size, "%s://%s:%d/%s", protocol, client->config.host, client->config.port, remote_path);
+		}
+		else
+		{
+			written = snprintf(url, url_size, "%s://%s:%d/", protocol, client->config.host, client->config.port);
+		}
+
+		/* Check if truncation occurred */
+		if (written < 0 || (size_t)written >= url_size)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		return FTP_OK;
+	}
+
+	static int build_ftp_dir_url(const ftp_client_t *client, const char *remote_path, char *url, size_t url_size)
+	{
+		char dir_path[FTP_MAX_URL_LENGTH];
+
+		/* Ensure path ends with / to indicate it's a directory */
+		size_t len = strlen(remote_path);
+		if (len > 0 && remote_path[len - 1] != '/')
+		{
+			snprintf(dir_path, sizeof(dir_path), "%s/", remote_path);
+		}
+		else
+		{
+			/* Copy as-is if it already ends with / */
+			snprintf(dir_path, sizeof(dir_path), "%s", remote_path);
+		}
+
+		return build_ftp_url(client, dir_path, url, url_size);
+	}
+
+	static void setup_progress_callback(ftp_client_t *client, CURL *curl)
+	{
+		if (client->config.progress_callback)
+		{
+			curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback_wrapper);
+			curl_easy_setopt(curl, CURLOPT_XFERINFODATA, client);
+			curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+		}
+		else
+		{
+			curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+		}
+	}
+
+	static void setup_curl_common(ftp_client_t *client, CURL *curl)
+	{
+		curl_easy_setopt(curl, CURLOPT_USERNAME, client->config.username);
+		curl_easy_setopt(curl, CURLOPT_PASSWORD, client->config.password);
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT, client->config.timeout);
+		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, client->config.connect_timeout);
+		curl_easy_setopt(curl, CURLOPT_VERBOSE, client->config.verbose ? 1L : 0L);
+
+		/* Keep idle control connections alive between session operations */
+		if (client->config.keep_session)
+		{
+			curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+		}
+
+		/* Transfer buffers */
+		if (client->config.receive_buffer_size > 0)
+		{
+			curl_easy_setopt(curl, CURLOPT_BUFFERSIZE, client->config.receive_buffer_size);
+		}
+#if LIBCURL_VERSION_NUM >= 0x073E00
+		if (client->config.upload_buffer_size > 0)
+		{
+			curl_easy_setopt(curl, CURLOPT_UPLOAD_BUFFERSIZE, client->config.upload_buffer_size);
+		}
+#endif
+
+		/* Track control connections for session statistics */
+		curl_easy_setopt(curl, CURLOPT_OPENSOCKETFUNCTION, open_socket_callback);
+		curl_easy_setopt(curl, CURLOPT_OPENSOCKETDATA, client);
+
+		/* Transfer mode */
+		if (client->config.mode == FTP_MODE_ACTIVE)
+		{
+			curl_easy_setopt(curl, CURLOPT_FTPPORT, "-");
+		}
+		else
+		{
+			curl_easy_setopt(curl, CURLOPT_FTP_USE_EPSV, 1L);
+		}
+
+		/* SSL/TLS settings */
+		if (client->config.ssl_mode != FTP_SSL_NONE)
+		{
+			curl_easy_setopt(curl, CURLOPT_USE_SSL, (long)client->config.ssl_mode);
+			curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, client->config.verify_ssl ? 1L : 0L);
+			curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, client->config.verify_ssl ? 2L : 0L);
+		}
+
+		setup_progress_callback(client, curl);
+	}
+
+	/* Restore the options that individual operations set back to their defaults */
+	static void clear_operation_options(ftp_client_t *client)
+	{
+		curl_easy_setopt(client->curl, CURLOPT_UPLOAD, 0L);
+		curl_easy_setopt(client->curl, CURLOPT_APPEND, 0L);
+		curl_easy_setopt(client->curl, CURLOPT_NOBODY, 0L);
+		curl_easy_setopt(client->curl, CURLOPT_HEADER, 0L);
+		curl_easy_setopt(client->curl, CURLOPT_FILETIME, 0L);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)-1);
+		curl_easy_setopt(client->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0);
+		curl_easy_setopt(client->curl, CURLOPT_RANGE, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_CUSTOMREQUEST, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_READFUNCTION, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_READDATA, stdin);
+		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, stdout);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGFUNCTION, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGDATA, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, client->config.verbose ? 1L : 0L);
+		setup_progress_callback(client, client->curl);
+	}
+
+	/* Forget the previous operation's statistics, so one that fails before reaching the server reports zeros */
+	static void reset_transfer_stats(ftp_client_t *client)
+	{
+		memset(&client->transfer_stats, 0, sizeof(client->transfer_stats));
+	}
+
+	/* Prepare the curl handle for a new operation */
+	static void prepare_curl_handle(ftp_client_t *client)
+	{
+		reset_transfer_stats(client);
+		if (client->config.keep_session && client->options_applied)
+		{
+			clear_operation_options(client);
+		}
+		else
+		{
+			curl_easy_reset(client->curl);
+			setup_curl_common(client, client->curl);
+			client->options_applied = client->config.keep_session;
+		}
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		struct ftp_compression_state *state = client->compression_state;
+		if (state)
+		{
+			state->requested = 0;
+			curl_easy_setopt(client->curl, CURLOPT_PREQUOTE, NULL);
+			curl_easy_setopt(client->curl, CURLOPT_POSTQUOTE, NULL);
+			curl_easy_setopt(client->curl, CURLOPT_IGNORE_CONTENT_LENGTH, 0L);
+
+			/* Replace a connection that may still be in MODE Z; keeping one connection closes the old one.
+			 * Session mode keeps options between operations, so restore libcurl's default of 5 afterwards */
+			curl_easy_setopt(client->curl, CURLOPT_FRESH_CONNECT, state->stale ? 1L : 0L);
+			curl_easy_setopt(client->curl, CURLOPT_MAXCONNECTS, state->stale ? 1L : 5L);
+		}
+#endif
+	}
+
+	/* Read a numeric transfer info value, 0 if libcurl does not report it */
+#if LIBCURL_VERSION_NUM >= 0x073D00
+	static double transfer_info(CURL *curl, CURLINFO info)
+	{
+		curl_off_t value = 0;
+		curl_easy_getinfo(curl, info, &value);
+		return (double)value;
+	}
+#define FTP_INFO_SIZE_UPLOAD CURLINFO_SIZE_UPLOAD_T
+#define FTP_INFO_SIZE_DOWNLOAD CURLINFO_SIZE_DOWNLOAD_T
+#define FTP_INFO_SPEED_UPLOAD CURLINFO_SPEED_UPLOAD_T
+#define FTP_INFO_SPEED_DOWNLOAD CURLINFO_SPEED_DOWNLOAD_T
+#define FTP_INFO_SECONDS(curl, info) (transfer_info(curl, info##_T) / 1e6)
+#else
+	static double transfer_info(CURL *curl, CURLINFO info)
+	{
+		double value = 0;
+		curl_easy_getinfo(curl, info, &value);
+		return value;
+	}
+#define FTP_INFO_SIZE_UPLOAD CURLINFO_SIZE_UPLOAD
+#define FTP_INFO_SIZE_DOWNLOAD CURLINFO_SIZE_DOWNLOAD
+#define FTP_INFO_SPEED_UPLOAD CURLINFO_SPEED_UPLOAD
+#define FTP_INFO_SPEED_DOWNLOAD CURLINFO_SPEED_DOWNLOAD
+#define FTP_INFO_SECONDS(curl, info) transfer_info(curl, info)
+#endif
+
+	/* Collect the timing breakdown and byte counts of a finished transfer */
+	static void read_transfer_stats(CURL *curl, ftp_transfer_stats_t *stats)
+	{
+		stats->bytes_uploaded = (int64_t)transfer_info(curl, FTP_INFO_SIZE_UPLOAD);
+		stats->bytes_downloaded = (int64_t)transfer_info(curl, FTP_INFO_SIZE_DOWNLOAD);
+		stats->upload_speed = transfer_info(curl, FTP_INFO_SPEED_UPLOAD);
+		stats->download_speed = transfer_info(curl, FTP_INFO_SPEED_DOWNLOAD);
+		stats->namelookup_time = FTP_INFO_SECONDS(curl, CURLINFO_NAMELOOKUP_TIME);
+		stats->connect_time = FTP_INFO_SECONDS(curl, CURLINFO_CONNECT_TIME);
+		stats->appconnect_time = FTP_INFO_SECONDS(curl, CURLINFO_APPCONNECT_TIME);
+		stats->pretransfer_time = FTP_INFO_SECONDS(curl, CURLINFO_PRETRANSFER_TIME);
+		stats->starttransfer_time = FTP_INFO_SECONDS(curl, CURLINFO_STARTTRANSFER_TIME);
+		stats->total_time = FTP_INFO_SECONDS(curl, CURLINFO_TOTAL_TIME);
+
+		stats->connections_opened = 0;
+		curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &stats->connections_opened);
+	}
+
+	/* Fold the statistics of a concurrent transfer into a combined total: bytes and
+	 * connections add up, phase times are those of the slowest transfer */
+	static void merge_transfer_stats(ftp_transfer_stats_t *total, const ftp_transfer_stats_t *part)
+	{
+		total->bytes_uploaded += part->bytes_uploaded;
+		total->bytes_downloaded += part->bytes_downloaded;
+		total->connections_opened += part->connections_opened;
+		total->namelookup_time = part->namelookup_time > total->namelookup_time ? part->namelookup_time : total->namelookup_time;
+		total->connect_time = part->connect_time > total->connect_time ? part->connect_time : total->connect_time;
+		total->appconnect_time = part->appconnect_time > total->appconnect_time ? part->appconnect_time : total->appconnect_time;
+		total->pretransfer_time = part->pretransfer_time > total->pretransfer_time ? part->pretransfer_time : total->pretransfer_time;
+		total->starttransfer_time =
+			part->starttransfer_time > total->starttransfer_time ? part->starttransfer_time : total->starttransfer_time;
+		total->total_time = part->total_time > total->total_time ? part->total_time : total->total_time;
+
+		if (total->total_time > 0)
+		{
+			total->upload_speed = total->bytes_uploaded / total->total_time;
+			total->download_speed = total->bytes_downloaded / total->total_time;
+		}
+	}
+
+	/* Run the configured transfer and record its statistics and whether it reused a connection */
+	static CURLcode perform_curl(ftp_client_t *client)
+	{
+		unsigned long opened_before = client->session_stats.connections_opened;
+
+		CURLcode res = curl_easy_perform(client->curl);
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		/* Successful compressed transfers switch back with MODE S afterwards; failed ones may not */
+		struct ftp_compression_state *state = client->compression_state;
+		if (state)
+		{
+			/* Compressed transfers ignore the announced length, so the end of the zlib stream is the only
+			 * proof that nothing is missing when the data connection closes */
+			state->truncated = res == CURLE_OK && state->requested && state->stats.compressed && !state->finished;
+			if (state->truncated)
+			{
+				res = CURLE_PARTIAL_FILE;
+			}
+			state->stale = state->requested && state->stats.compressed && res != CURLE_OK;
+		}
+#endif
+
+		read_transfer_stats(client->curl, &client->transfer_stats);
+
+		client->session_stats.operations++;
+		if (res == CURLE_OK && client->session_stats.connections_opened == opened_before)
+		{
+			client->session_stats.connections_reused++;
+		}
+
+		return res;
+	}
+
+	/* Error text for a failed download; a compressed stream that ended early is reported as such */
+	static const char *download_error_text(const ftp_client_t *client, CURLcode res)
+	{
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		if (client->compression_state && client->compression_state->truncated)
+		{
+			return "compressed stream truncated";
+		}
+#else
+		(void)client;
+#endif
+		return curl_easy_strerror(res);
+	}
+
+	/* Server features detected with FEAT */
+#define FTP_FEATURE_PROBED 0x01u
+#define FTP_FEATURE_MLSD 0x02u
+#define FTP_FEATURE_MODE_Z 0x04u
+
+	/* Case-insensitive comparison of a length-delimited token with a keyword */
+	static int token_equals(const char *token, size_t len, const char *keyword)
+	{
+		size_t i;
+		for (i = 0; i < len; i++)
+		{
+			if (keyword[i] == '\0' || tolower((unsigned char)token[i]) != tolower((unsigned char)keyword[i]))
+			{
+				return 0;
+			}
+		}
+		return keyword[len] == '\0';
+	}
+
+	static int feature_debug_callback(CURL *handle, curl_infotype type, char *data, size_t size, void *userp)
+	{
+		ftp_client_t *client = (ftp_client_t *)userp;
+		(void)handle;
+
+		echo_verbose_output(client, type, data, size);
+
+		/* FEAT lists one feature per line, indented by a space: " MLST type*;size*;" */
+		while (type == CURLINFO_HEADER_IN && size > 0)
+		{
+			const char *eol = (const char *)memchr(data, '\n', size);
+			size_t line_len = eol ? (size_t)(eol - data) + 1 : size;
+			size_t name_len = 0;
+			if (data[0] == ' ')
+			{
+				while (1 + name_len < line_len && !isspace((unsigned char)data[1 + name_len]))
+				{
+					name_len++;
+				}
+				if (token_equals(data + 1, name_len, "MLST"))
+				{
+					client->server_features |= FTP_FEATURE_MLSD;
+				}
+				else if (token_equals(data + 1, name_len, "MODE"))
+				{
+					/* " MODE Z" announces deflate transfers */
+					size_t arg = 1 + name_len;
+					while (arg < line_len && data[arg] == ' ')
+					{
+						arg++;
+					}
+					if (arg < line_len && (data[arg] == 'Z' || data[arg] == 'z') &&
+						(arg + 1 == line_len || isspace((unsigned char)data[arg + 1])))
+					{
+						client->server_features |= FTP_FEATURE_MODE_Z;
+					}
+				}
+			}
+			data += line_len;
+			size -= line_len;
+		}
+
+		return 0;
+	}
+
+	/* Ask the server for its extensions once; the result is kept in the client */
+	static void probe_server_features(ftp_client_t *client)
+	{
+		if (client->server_features & FTP_FEATURE_PROBED)
+		{
+			return;
+		}
+
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		if (build_ftp_url(client, "/", url, sizeof(url)) != FTP_OK)
+		{
+			return;
+		}
+
+		/* '*' keeps servers without FEAT from failing the probe */
+		struct curl_slist *commands = curl_slist_append(NULL, "*FEAT");
+		if (!commands)
+		{
+			return;
+		}
+
+		client->server_features = 0;
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, commands);
+		curl_easy_setopt(client->curl, CURLOPT_NOBODY, 1L);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGFUNCTION, feature_debug_callback);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGDATA, client);
+		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, 1L);
+
+		CURLcode res = perform_curl(client);
+
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGFUNCTION, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGDATA, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, client->config.verbose ? 1L : 0L);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, NULL);
+		curl_slist_free_all(commands);
+
+		/* Probe again next time if the server could not be reached */
+		client->server_features = res == CURLE_OK ? client->server_features | FTP_FEATURE_PROBED : 0;
+	}
+
+	/* Prepare the curl handle for a file transfer, which may use MODE Z if the server offers it */
+	static void prepare_transfer_handle(ftp_client_t *client, int compressible)
+	{
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		compressible = compressible && client->config.compression_level > 0;
+		if (compressible)
+		{
+			probe_server_features(client);
+			if ((client->server_features & FTP_FEATURE_MODE_Z) && !client->compression_state)
+			{
+				client->compression_state = compression_state_create();
+			}
+		}
+
+		prepare_curl_handle(client);
+		if (client->compression_state)
+		{
+			client->compression_state->requested = compressible && (client->server_features & FTP_FEATURE_MODE_Z);
+		}
+#else
+		(void)compressible;
+		prepare_curl_handle(client);
+#endif
+	}
+
+	static int ftp_client_execute_simple_command(ftp_client_t *client, struct curl_slist *commands,
+												 const char *error_prefix)
+	{
+		if (!client || !client->curl || !commands)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, "/", url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "%s: URL too long", error_prefix);
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, commands);
+
+		ftp_memory_buffer_t buffer = {0};
+		set_reply_callback(client, write_memory_callback, &buffer);
+
+		CURLcode res = perform_curl(client);
+
+		if (buffer.data)
+		{
+			free(buffer.data);
+		}
+
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "%s: %s", error_prefix, curl_easy_strerror(res));
+
+			if (res == CURLE_LOGIN_DENIED)
+			{
+				return FTP_ERROR_AUTH;
+			}
+			else if (res == CURLE_OPERATION_TIMEDOUT)
+			{
+				return FTP_ERROR_TIMEOUT;
+			}
+			return FTP_ERROR_TRANSFER;
+		}
+
+		return FTP_OK;
+	}
+
+	/* Remote metadata cache */
+
+#define FTP_CACHE_DEFAULT_ENTRIES 4096
+
+	typedef struct ftp_cache_entry
+	{
+		char *key; /* "user@host:port" NUL path */
+		size_t key_size;
+		uint32_t hash;
+		int64_t size;  /* -1 if not cached */
+		int64_t mtime; /* -1 if not cached */
+		int64_t info_expires_ms;
+		char *listing;
+		size_t listing_size;
+		int64_t listing_expires_ms;
+		struct ftp_cache_entry *hash_next;
+		struct ftp_cache_entry *lru_prev; /* Most recently used first */
+		struct ftp_cache_entry *lru_next;
+	} ftp_cache_entry_t;
+
+	struct ftp_cache
+	{
+		ftp_mutex_t mutex;
+		int64_t ttl_ms;
+		size_t max_entries;
+		ftp_cache_entry_t **buckets;
+		size_t bucket_mask;
+		ftp_cache_entry_t *lru_head;
+		ftp_cache_entry_t *lru_tail;
+		ftp_cache_stats_t stats;
+	};
+
+	/* Cache key of a path: server identity and path without trailing slashes */
+	typedef struct
+	{
+		char data[FTP_MAX_URL_LENGTH];
+		size_t size;
+		size_t path_offset;
+	} ftp_cache_key_t;
+
+	static int cache_make_key(const ftp_client_t *client, const char *path, size_t path_len, ftp_cache_key_t *key)
+	{
+		while (path_len > 1 && path[path_len - 1] == '/')
+		{
+			path_len--;
+		}
+
+		int prefix = snprintf(key->data, sizeof(key->data), "%s@%s:%d", client->config.username ? client->config.username : "",
+							  client->config.host ? client->config.host : "", client->config.port);
+		if (prefix < 0 || (size_t)prefix + 1 + path_len >= sizeof(key->data))
+		{
+			return 0;
+		}
+
+		key->path_offset = (size_t)prefix + 1;
+		memcpy(key->data + key->path_offset, path, path_len);
+		key->size = key->path_offset + path_len;
+		key->data[key->size] = '\0';
+		return 1;
+	}
+
+	/* Key of the directory containing path */
+	static int cache_make_parent_key(const ftp_client_t *client, const char *path, ftp_cache_key_t *key)
+	{
+		size_t len = strlen(path);
+		while (len > 1 && path[len - 1] == '/')
+		{
+			len--;
+		}
+		while (len > 0 && path[len - 1] != '/')
+		{
+			len--;
+		}
+		return cache_make_key(client, path, len, key);
+	}
+
+	static uint32_t cache_hash(const char *data, size_t size)
+	{
+		uint32_t hash = 2166136261u;
+		size_t i;
+		for (i = 0; i < size; i++)
+		{
+			hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	static void cache_lru_unlink(ftp_cache_t *cache, ftp_cache_entry_t *entry)
+	{
+		if (entry->lru_prev)
+		{
+			entry->lru_prev->lru_next = entry->lru_next;
+		}
+		else
+		{
+			cache->lru_head = entry->lru_next;
+		}
+		if (entry->lru_next)
+		{
+			entry->lru_next->lru_prev = entry->lru_prev;
+		}
+		else
+		{
+			cache->lru_tail = entry->lru_prev;
+		}
+	}
+
+	static void cache_lru_push_front(ftp_cache_t *cache, ftp_cache_entry_t *entry)
+	{
+		entry->lru_prev = NULL;
+		entry->lru_next = cache->lru_head;
+		if (cache->lru_head)
+		{
+			cache->lru_head->lru_prev = entry;
+		}
+		cache->lru_head = entry;
+		if (!cache->lru_tail)
+		{
+			cache->lru_tail = entry;
+		}
+	}
+
+	/* Unlink and free an entry; caller holds the mutex */
+	static void cache_remove_entry(ftp_cache_t *cache, ftp_cache_entry_t *entry)
+	{
+		ftp_cache_entry_t **link = &cache->buckets[entry->hash & cache->bucket_mask];
+		while (*link != entry)
+		{
+			link = &(*link)->hash_next;
+		}
+		*link = entry->hash_next;
+		cache_lru_unlink(cache, entry);
+		cache->stats.entries--;
+		free(entry->listing);
+		free(entry->key);
+		free(entry);
+	}
+
+	static ftp_cache_entry_t *cache_find(ftp_cache_t *cache, const ftp_cache_key_t *key, uint32_t hash)
+	{
+		ftp_cache_entry_t *entry = cache->buckets[hash & cache->bucket_mask];
+		while (entry && (entry->hash != hash || entry->key_size != key->size ||
+						 memcmp(entry->key, key->data, key->size) != 0))
+		{
+			entry = entry->hash_next;
+		}
+		return entry;
+	}
+
+	/* Find or create the entry for a key and mark it most recently used; caller holds the mutex */
+	static ftp_cache_entry_t *cache_get_entry(ftp_cache_t *cache, const ftp_cache_key_t *key)
+	{
+		uint32_t hash = cache_hash(key->data, key->size);
+		ftp_cache_entry_t *entry = cache_find(cache, key, hash);
+		if (entry)
+		{
+			cache_lru_unlink(cache, entry);
+			cache_lru_push_front(cache, entry);
+			return entry;
+		}
+
+		if (cache->stats.entries >= cache->max_entries && cache->lru_tail)
+		{
+			cache_remove_entry(cache, cache->lru_tail);
+			cache->stats.evictions++;
+		}
+
+		entry = (ftp_cache_entry_t *)calloc(1, sizeof(ftp_cache_entry_t));
+		if (!entry || !(entry->key = (char *)malloc(key->size + 1)))
+		{
+			free(entry);
+			return NULL;
+		}
+		memcpy(entry->key, key->data, key->size + 1);
+		entry->key_size = key->size;
+		entry->hash = hash;
+		entry->size = -1;
+		entry->mtime = -1;
+		entry->hash_next = cache->buckets[hash & cache->bucket_mask];
+		cache->buckets[hash & cache->bucket_mask] = entry;
+		cache_lru_push_front(cache, entry);
+		cache->stats.entries++;
+		return entry;
+	}
+
+	/* Look up size and/or time of a path; succeeds only if every requested value is cached */
+	static int cache_lookup_info(ftp_client_t *client, const char *path, int64_t *size, int64_t *mtime)
+	{
+		ftp_cache_t *cache = client->cache;
+		ftp_cache_key_t key;
+		if (!cache || !cache_make_key(client, path, strlen(path), &key))
+		{
+			return 0;
+		}
+
+		int found = 0;
+		ftp_mutex_lock(&cache->mutex);
+		ftp_cache_entry_t *entry = cache_find(cache, &key, cache_hash(key.data, key.size));
+		if (entry && entry->info_expires_ms > ftp_time_ms() && (!size || entry->size >= 0) &&
+			(!mtime || entry->mtime >= 0))
+		{
+			if (size)
+			{
+				*size = entry->size;
+			}
+			if (mtime)
+			{
+				*mtime = entry->mtime;
+			}
+			found = 1;
+		}
+		if (found)
+		{
+			cache->stats.hits++;
+		}
+		else
+		{
+			cache->stats.misses++;
+		}
+		ftp_mutex_unlock(&cache->mutex);
+		return found;
+	}
+
+	static void cache_store_info(ftp_client_t *client, const char *path, int64_t size, int64_t mtime)
+	{
+		ftp_cache_t *cache = client->cache;
+		ftp_cache_key_t key;
+		if (!cache || !cache_make_key(client, path, strlen(path), &key))
+		{
+			return;
+		}
+
+		ftp_mutex_lock(&cache->mutex);
+		ftp_cache_entry_t *entry = cache_get_entry(cache, &key);
+		if (entry)
+		{
+			entry->size = size;
+			entry->mtime = mtime;
+			entry->info_expires_ms = ftp_time_ms() + cache->ttl_ms;
+		}
+		ftp_mutex_unlock(&cache->mutex);
+	}
+
+	/* Return a malloc'd copy of a cached listing, or NULL */
+	static char *cache_lookup_listing(ftp_client_t *client, const char *path)
+	{
+		ftp_cache_t *cache = client->cache;
+		ftp_cache_key_t key;
+		if (!cache || !cache_make_key(client, path, strlen(path), &key))
+		{
+			return NULL;
+		}
+
+		char *copy = NULL;
+		ftp_mutex_lock(&cache->mutex);
+		ftp_cache_entry_t *entry = cache_find(cache, &key, cache_hash(key.data, key.size));
+		if (entry && entry->listing && entry->listing_expires_ms > ftp_time_ms())
+		{
+			copy = (char *)malloc(entry->listing_size + 1);
+			if (copy)
+			{
+				memcpy(copy, entry->listing, entry->listing_size + 1);
+			}
+		}
+		if (copy)
+		{
+			cache->stats.hits++;
+		}
+		else
+		{
+			cache->stats.misses++;
+		}
+		ftp_mutex_unlock(&cache->mutex);
+		return copy;
+	}
+
+	static void cache_store_listing(ftp_client_t *client, const char *path, const char *listing)
+	{
+		ftp_cache_t *cache = client->cache;
+		ftp_cache_key_t key;
+		if (!cache || !cache_make_key(client, path, strlen(path), &key))
+		{
+			return;
+		}
+
+		size_t size = strlen(listing);
+		char *copy = (char *)malloc(size + 1);
+		if (!copy)
+		{
+			return;
+		}
+		memcpy(copy, listing, size + 1);
+
+		ftp_mutex_lock(&cache->mutex);
+		ftp_cache_entry_t *entry = cache_get_entry(cache, &key);
+		if (entry)
+		{
+			free(entry->listing);
+			entry->listing = copy;
+			entry->listing_size = size;
+			entry->listing_expires_ms = ftp_time_ms() + cache->ttl_ms;
+			copy = NULL;
+		}
+		ftp_mutex_unlock(&cache->mutex);
+		free(copy);
+	}
+
+	/* Drop a cache key; with tree set, also every key below it. Caller holds the mutex. */
+	static void cache_drop_key(ftp_cache_t *cache, const ftp_cache_key_t *key, int tree)
+	{
+		ftp_cache_entry_t *entry = cache_find(cache, key, cache_hash(key->data, key->size));
+		if (entry)
+		{
+			cache_remove_entry(cache, entry);
+			cache->stats.invalidations++;
+		}
+
+		if (tree)
+		{
+			ftp_cache_entry_t *next;
+			for (entry = cache->lru_head; entry; entry = next)
+			{
+				next = entry->lru_next;
+				if (entry->key_size > key->size && memcmp(entry->key, key->data, key->size) == 0 &&
+					(entry->key[key->size] == '/' || key->data[key->size - 1] == '/'))
+				{
+					cache_remove_entry(cache, entry);
+					cache->stats.invalidations++;
+				}
+			}
+		}
+	}
+
+	/* Forget a path that was changed through this client, and the listing of its directory */
+	static void cache_invalidate(ftp_client_t *client, const char *path, int tree)
+	{
+		ftp_cache_t *cache = client->cache;
+		ftp_cache_key_t key, parent;
+		if (!cache || !cache_make_key(client, path, strlen(path), &key))
+		{
+			return;
+		}
+
+		int has_parent = cache_make_parent_key(client, path, &parent);
+		ftp_mutex_lock(&cache->mutex);
+		cache_drop_key(cache, &key, tree);
+		if (has_parent)
+		{
+			cache_drop_key(cache, &parent, 0);
+		}
+		ftp_mutex_unlock(&cache->mutex);
+	}
+
+	ftp_cache_t *ftp_cache_create(long ttl, size_t max_entries)
+	{
+		if (ttl <= 0)
+		{
+			return NULL;
+		}
+
+		ftp_cache_t *cache = (ftp_cache_t *)calloc(1, sizeof(ftp_cache_t));
+		if (!cache)
+		{
+			return NULL;
+		}
+
+		cache->ttl_ms = (int64_t)ttl * 1000;
+		cache->max_entries = max_entries ? max_entries : FTP_CACHE_DEFAULT_ENTRIES;
+
+		size_t buckets = 16;
+		while (buckets < cache->max_entries)
+		{
+			buckets *= 2;
+		}
+		cache->buckets = (ftp_cache_entry_t **)calloc(buckets, sizeof(ftp_cache_entry_t *));
+		if (!cache->buckets)
+		{
+			free(cache);
+			return NULL;
+		}
+		cache->bucket_mask = buckets - 1;
+
+		ftp_mutex_init(&cache->mutex);
+		return cache;
+	}
+
+	void ftp_client_set_cache(ftp_client_t *client, ftp_cache_t *cache)
+	{
+		if (client)
+		{
+			client->cache = cache;
+		}
+	}
+
+	int ftp_client_set_max_speed(ftp_client_t *client, int64_t send_rate, int64_t receive_rate)
+	{
+		if (!client)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		client->config.max_send_speed = send_rate > 0 ? send_rate : 0;
+		client->config.max_receive_speed = receive_rate > 0 ? receive_rate : 0;
+
+		struct ftp_throttle_state *throttle = client->throttle_state;
+		if (!throttle && (send_rate > 0 || receive_rate > 0))
+		{
+			throttle = client->throttle_state = (struct ftp_throttle_state *)calloc(1, sizeof(struct ftp_throttle_state));
+			if (!throttle)
+			{
+				return FTP_ERROR_MEMORY;
+			}
+		}
+
+		if (throttle && !throttle->own && (send_rate > 0 || receive_rate > 0))
+		{
+			throttle->own = ftp_rate_limiter_create(send_rate, receive_rate);
+			return throttle->own ? FTP_OK : FTP_ERROR_MEMORY;
+		}
+		if (throttle && throttle->own)
+		{
+			ftp_rate_limiter_set_rates(throttle->own, send_rate, receive_rate);
+		}
+		return FTP_OK;
+	}
+
+	void ftp_client_set_rate_limiter(ftp_client_t *client, ftp_rate_limiter_t *limiter)
+	{
+		if (client)
+		{
+			client->rate_limiter = limiter;
+		}
+	}
+
+	void ftp_cache_clear(ftp_cache_t *cache)
+	{
+		if (cache)
+		{
+			ftp_mutex_lock(&cache->mutex);
+			while (cache->lru_head)
+			{
+				cache_remove_entry(cache, cache->lru_head);
+			}
+			ftp_mutex_unlock(&cache->mutex);
+		}
+	}
+
+	int ftp_cache_get_stats(ftp_cache_t *cache, ftp_cache_stats_t *stats)
+	{
+		if (!cache || !stats)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		ftp_mutex_lock(&cache->mutex);
+		*stats = cache->stats;
+		ftp_mutex_unlock(&cache->mutex);
+		return FTP_OK;
+	}
+
+	void ftp_cache_destroy(ftp_cache_t *cache)
+	{
+		if (cache)
+		{
+			ftp_cache_clear(cache);
+			ftp_mutex_destroy(&cache->mutex);
+			free(cache->buckets);
+			free(cache);
+		}
+	}
+
+	int ftp_global_init(void)
+	{
+		CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
+		return (res == CURLE_OK) ? FTP_OK : FTP_ERROR_INIT;
+	}
+
+	void ftp_global_cleanup(void)
+	{
+		curl_global_cleanup();
+	}
+
+	ftp_client_t *ftp_client_create(void)
+	{
+		ftp_client_t *client = (ftp_client_t *)calloc(1, sizeof(ftp_client_t));
+		if (!client)
+		{
+			return NULL;
+		}
+
+		client->curl = curl_easy_init();
+		if (!client->curl)
+		{
+			free(client);
+			return NULL;
+		}
+
+		if (ftp_client_init_config(&client->config) != FTP_OK)
+		{
+			curl_easy_cleanup(client->curl);
+			free(client);
+			return NULL;
+		}
+		return client;
+	}
+
+	int ftp_client_init_config(ftp_config_t *config)
+	{
+		memset(config, 0, sizeof(ftp_config_t));
+		config->host = NULL;
+		config->port = 21;
+		config->username = strdup("anonymous");
+		config->password = strdup("user@example.com");
+
+		if (!config->username || !config->password)
+		{
+			free(config->username);
+			free(config->password);
+			return FTP_ERROR_MEMORY;
+		}
+
+		config->mode = FTP_MODE_PASSIVE;
+		config->ssl_mode = FTP_SSL_NONE;
+		config->verify_ssl = 1;
+		config->timeout = 60;
+		config->connect_timeout = 30;
+		config->verbose = 0;
+		return FTP_OK;
+	}
+
+	int ftp_client_set_host(ftp_client_t *client, const char *host, int port)
+	{
+		if (!client)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		if (!host)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Host parameter is NULL");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		size_t host_len = strlen(host);
+		if (host_len == 0 || host_len > 255)
+		{
+			snprintf(client->last_error, sizeof(client->last_error),
+					 "Host length must be between 1 and 255 characters");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		for (size_t i = 0; i < host_len; i++)
+		{
+			char c = host[i];
+			if (c == '\0' || c == '/' || c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Host contains invalid characters");
+				return FTP_ERROR_INVALID_PARAM;
+			}
+		}
+
+		char *new_host = strdup(host);
+		if (!new_host)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for host");
+			return FTP_ERROR_MEMORY;
+		}
+
+		if (client->config.host)
+		{
+			free(client->config.host);
+		}
+		client->config.host = new_host;
+		client->options_applied = 0;
+		client->server_features = 0;
+
+		if (port > 0 && port <= 65535)
+		{
+			client->config.port = port;
+		}
+
+		return FTP_OK;
+	}
+
+	int ftp_client_set_credentials(ftp_client_t *client, const char *username, const char *password)
+	{
+		if (!client)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		if (!username)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Username parameter is NULL");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		if (!password)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Password parameter is NULL");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		size_t username_len = strlen(username);
+		size_t password_len = strlen(password);
+
+		/* Validate username and password lengths */
+		if (username_len == 0 || username_len > 255)
+		{
+			snprintf(client->last_error, sizeof(client->last_error),
+					 "Username length must be between 1 and 255 characters");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		if (password_len == 0 || password_len > 255)
+		{
+			snprintf(client->last_error, sizeof(client->last_error),
+					 "Password length must be between 1 and 255 characters");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		char *new_username = strdup(username);
+		if (!new_username)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for username");
+			return FTP_ERROR_MEMORY;
+		}
+
+		char *new_password = strdup(password);
+		if (!new_password)
+		{
+			free(new_username);
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for password");
+			return FTP_ERROR_MEMORY;
+		}
+
+		/* Free old credentials */
+		if (client->config.username)
+		{
+			free(client->config.username);
+		}
+		if (client->config.password)
+		{
+			free(client->config.password);
+		}
+
+		/* Set new credentials */
+		client->config.username = new_username;
+		client->config.password = new_password;
+		client->options_applied = 0;
+
+		return FTP_OK;
+	}
+
+	void ftp_client_set_mode(ftp_client_t *client, ftp_mode_t mode)
+	{
+		if (client)
+		{
+			client->config.mode = mode;
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_ssl(ftp_client_t *client, ftp_ssl_mode_t ssl_mode, int verify)
+	{
+		if (client)
+		{
+			client->config.ssl_mode = ssl_mode;
+			client->config.verify_ssl = verify;
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_timeout(ftp_client_t *client, long timeout, long connect_timeout)
+	{
+		if (client)
+		{
+			if (timeout > 0)
+			{
+				client->config.timeout = timeout;
+			}
+			if (connect_timeout > 0)
+			{
+				client->config.connect_timeout = connect_timeout;
+			}
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_verbose(ftp_client_t *client, int verbose)
+	{
+		if (client)
+		{
+			client->config.verbose = verbose;
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_progress_callback(ftp_client_t *client, ftp_progress_callback_t callback, void *user_data)
+	{
+		if (client)
+		{
+			client->config.progress_callback = callback;
+			client->config.progress_user_data = user_data;
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_download_resume(ftp_client_t *client, int enable)
+	{
+		if (client)
+		{
+			client->config.resume_downloads = enable ? 1 : 0;
+		}
+	}
+
+	void ftp_client_set_upload_mmap(ftp_client_t *client, int enable)
+	{
+		if (client)
+		{
+			client->config.mmap_uploads = enable ? 1 : 0;
+		}
+	}
+
+	void ftp_client_set_download_preallocate(ftp_client_t *client, int enable)
+	{
+		if (client)
+		{
+			client->config.preallocate_downloads = enable ? 1 : 0;
+		}
+	}
+
+	void ftp_client_set_download_atomic(ftp_client_t *client, int enable)
+	{
+		if (client)
+		{
+			client->config.atomic_downloads = enable ? 1 : 0;
+		}
+	}
+
+	void ftp_client_set_download_fsync(ftp_client_t *client, ftp_fsync_policy_t policy)
+	{
+		if (client && policy >= FTP_FSYNC_NONE && policy <= FTP_FSYNC_FILE_AND_DIR)
+		{
+			client->config.fsync_policy = policy;
+		}
+	}
+
+	void ftp_client_set_buffer_sizes(ftp_client_t *client, long receive_buffer, long upload_buffer,
+									 size_t file_buffer)
+	{
+		if (client)
+		{
+			client->config.receive_buffer_size = receive_buffer > 0 ? receive_buffer : 0;
+			client->config.upload_buffer_size = upload_buffer > 0 ? upload_buffer : 0;
+			client->config.file_buffer_size = file_buffer;
+			client->options_applied = 0;
+		}
+	}
+
+	void ftp_client_set_checksums(ftp_client_t *client, unsigned int types)
+	{
+		if (client)
+		{
+			client->config.checksum_types = types & (FTP_CHECKSUM_CRC32C | FTP_CHECKSUM_XXH64 | FTP_CHECKSUM_SHA256);
+		}
+	}
+
+	int ftp_client_get_checksums(ftp_client_t *client, ftp_checksums_t *checksums)
+	{
+		if (!client || !checksums)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		memset(checksums, 0, sizeof(*checksums));
+		struct ftp_checksum_state *state = client->checksum_state;
+		if (state && state->types)
+		{
+			checksums->types = state->types;
+			checksums->bytes = state->bytes;
+			checksums->crc32c = state->crc32c;
+			if (state->types & FTP_CHECKSUM_XXH64)
+			{
+				checksums->xxh64 = xxh64_digest(&state->xxh64);
+			}
+			if (state->types & FTP_CHECKSUM_SHA256)
+			{
+				sha256_digest(&state->sha256, checksums->sha256);
+			}
+		}
+		return FTP_OK;
+	}
+
+	int ftp_client_set_compression(ftp_client_t *client, int level)
+	{
+		if (!client)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		if (level < 0 || level > 9)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Invalid compression level %d", level);
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		client->config.compression_level = level;
+		return FTP_OK;
+#else
+		if (level != 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error),
+					 "Compression requires building with FTP_CLIENT_ENABLE_ZLIB");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		return FTP_OK;
+#endif
+	}
+
+	int ftp_client_get_compression_stats(ftp_client_t *client, ftp_compression_stats_t *stats)
+	{
+		if (!client || !stats)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		memset(stats, 0, sizeof(*stats));
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+		if (client->compression_state)
+		{
+			*stats = client->compression_state->stats;
+		}
+#endif
+		return FTP_OK;
+	}
+
+	void ftp_client_set_session_reuse(ftp_client_t *client, int enable)
+	{
+		if (client)
+		{
+			client->config.keep_session = enable ? 1 : 0;
+			client->options_applied = 0;
+		}
+	}
+
+	int ftp_client_get_session_stats(ftp_client_t *client, ftp_session_stats_t *stats)
+	{
+		if (!client || !stats)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		*stats = client->session_stats;
+		return FTP_OK;
+	}
+
+	int ftp_client_get_transfer_stats(ftp_client_t *client, ftp_transfer_stats_t *stats)
+	{
+		if (!client || !stats)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		*stats = client->transfer_stats;
+		return FTP_OK;
+	}
+
+	int ftp_client_connect(ftp_client_t *client)
+	{
+		if (!client || !client->curl)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		if (!client->config.host || client->config.host[0] == '\0')
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Host not set");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		struct curl_slist *commands = NULL;
+		commands = curl_slist_append(commands, "NOOP");
+
+		int result = ftp_client_execute_simple_command(client, commands, "Connection failed");
+
+		curl_slist_free_all(commands);
+
+		return result;
+	}
+
+	/* Update the cache after an upload; size is -1 if the upload failed and the remote state is unknown */
+	static void cache_file_written(ftp_client_t *client, const char *remote_path, int64_t size)
+	{
+		cache_invalidate(client, remote_path, 0);
+		if (size >= 0)
+		{
+			cache_store_info(client, remote_path, size, -1);
+		}
+	}
+
+	/* Local file being uploaded, either mapped or read through stdio */
+	typedef struct
+	{
+		FILE *fp;
+		char *stdio_buffer;
+		ftp_file_map_t map;
+		ftp_memory_reader_t reader;
+		int64_t size;
+	} ftp_upload_source_t;
+
+	static int upload_source_open(ftp_client_t *client, const char *local_path, ftp_upload_source_t *source)
+	{
+		memset(source, 0, sizeof(*source));
+
+		if (client->config.mmap_uploads && ftp_file_map(local_path, &source->map) == 0)
+		{
+			source->reader.data = source->map.data;
+			source->reader.size = source->map.size;
+			source->size = (int64_t)source->map.size;
+			return FTP_OK;
+		}
+
+		source->fp = fopen(local_path, "rb");
+		if (!source->fp)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot open local file: %s", local_path);
+			return FTP_ERROR_FILE_IO;
+		}
+
+		if (get_local_file_size(source->fp, &source->size) != 0)
+		{
+			fclose(source->fp);
+			source->fp = NULL;
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
+			return FTP_ERROR_FILE_IO;
+		}
+		source->stdio_buffer = ftp_file_prepare_stream(source->fp, client->config.file_buffer_size);
+		return FTP_OK;
+	}
+
+	static int upload_source_seek(ftp_upload_source_t *source, int64_t offset)
+	{
+		if (!source->fp)
+		{
+			source->reader.offset = (size_t)offset;
+			return 0;
+		}
+		return seek_local_file(source->fp, offset);
+	}
+
+	static void upload_source_close(ftp_upload_source_t *source)
+	{
+		if (source->fp)
+		{
+			fclose(source->fp);
+			source->fp = NULL;
+		}
+		free(source->stdio_buffer);
+		source->stdio_buffer = NULL;
+		ftp_file_unmap(&source->map);
+	}
+
+	/* Send size bytes produced by read_callback; append to the remote file if requested */
+	static int upload_stream(ftp_client_t *client, size_t (*read_callback)(void *, size_t, size_t, void *),
+							 void *read_data, int64_t size, const char *remote_path, int append)
+	{
+		prepare_transfer_handle(client, 1);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+
+		curl_easy_setopt(client->curl, CURLOPT_UPLOAD, 1L);
+		curl_easy_setopt(client->curl, CURLOPT_APPEND, append ? 1L : 0L);
+		curl_easy_setopt(client->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)size);
+		set_transfer_callback(client, 1, read_callback, read_data);
+
+		CURLcode res = perform_curl(client);
+
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Upload failed: %s", curl_easy_strerror(res));
+			return FTP_ERROR_TRANSFER;
+		}
+
+		return FTP_OK;
+	}
+
+	static int upload_source_send(ftp_client_t *client, ftp_upload_source_t *source, int64_t size,
+								  const char *remote_path, int append)
+	{
+		if (source->fp)
+		{
+			return upload_stream(client, read_file_callback, source->fp, size, remote_path, append);
+		}
+		return upload_stream(client, read_memory_callback, &source->reader, size, remote_path, append);
+	}
+
+	int ftp_client_upload(ftp_client_t *client, const char *local_path, const char *remote_path)
+	{
+		if (!client || !client->curl || !local_path || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		ftp_upload_source_t source;
+		int result = upload_source_open(client, local_path, &source);
+		if (result != FTP_OK)
+		{
+			return result;
+		}
+
+		result = upload_source_send(client, &source, source.size, remote_path, 0);
+		upload_source_close(&source);
+		cache_file_written(client, remote_path, result == FTP_OK ? source.size : -1);
+		return result;
+	}
+
+	int ftp_client_upload_from_memory(ftp_client_t *client, const void *data, size_t size, const char *remote_path)
+	{
+		if (!client || !client->curl || (!data && size > 0) || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		ftp_memory_reader_t reader;
+		reader.data = (const char *)data;
+		reader.size = size;
+		reader.offset = 0;
+
+		int result = upload_stream(client, read_memory_callback, &reader, (int64_t)size, remote_path, 0);
+		cache_file_written(client, remote_path, result == FTP_OK ? (int64_t)size : -1);
+		return result;
+	}
+
+	int ftp_client_upload_iov(ftp_client_t *client, const ftp_iovec_t *iov, size_t count, const char *remote_path)
+	{
+		if (!client || !client->curl || (!iov && count > 0) || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		int64_t total = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!iov[i].iov_base && iov[i].iov_len > 0)
+			{
+				return FTP_ERROR_INVALID_PARAM;
+			}
+			total += (int64_t)iov[i].iov_len;
+		}
+
+		ftp_iov_reader_t reader;
+		reader.iov = iov;
+		reader.count = count;
+		reader.index = 0;
+		reader.offset = 0;
+
+		int result = upload_stream(client, read_iov_callback, &reader, total, remote_path, 0);
+		cache_file_written(client, remote_path, result == FTP_OK ? total : -1);
+		return result;
+	}
+
+	/* Fetch size and time of a file in one round trip; either may be -1 if the server does not report it.
+	 * Always asks the server, so operations that depend on the current size call it instead of the cache */
+	static int query_file_info(ftp_client_t *client, const char *remote_path, int64_t *size, int64_t *mtime)
+	{
+		/* Reset curl handle to default state */
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+
+		/* Use NOBODY to get file info without downloading content */
+		curl_easy_setopt(client->curl, CURLOPT_NOBODY, 1L);
+		curl_easy_setopt(client->curl, CURLOPT_FILETIME, 1L);
+		curl_easy_setopt(client->curl, CURLOPT_HEADER, 1L);
+
+		/* Provide write callback to discard any header data */
+		ftp_memory_buffer_t buffer = {0};
+		set_reply_callback(client, write_memory_callback, &buffer);
+
+		CURLcode res = perform_curl(client);
+
+		if (buffer.data)
+		{
+			free(buffer.data);
+		}
+
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Get file info failed: %s",
+					 curl_easy_strerror(res));
+			return res == CURLE_REMOTE_FILE_NOT_FOUND ? FTP_ERROR_FILE_NOT_FOUND : FTP_ERROR_TRANSFER;
+		}
+
+		/* Get file size and time from curl info */
+		curl_off_t filesize = -1;
+		curl_off_t filetime = -1;
+		if (curl_easy_getinfo(client->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &filesize) != CURLE_OK)
+		{
+			filesize = -1;
+		}
+		if (curl_easy_getinfo(client->curl, CURLINFO_FILETIME_T, &filetime) != CURLE_OK)
+		{
+			filetime = -1;
+		}
+		*size = filesize >= 0 ? (int64_t)filesize : -1;
+		*mtime = filetime >= 0 ? (int64_t)filetime : -1;
+
+		if (*size >= 0 || *mtime >= 0)
+		{
+			cache_store_info(client, remote_path, *size, *mtime);
+		}
+		return FTP_OK;
+	}
+
+	int ftp_client_upload_resume(ftp_client_t *client, const char *local_path, const char *remote_path)
+	{
+		if (!client || !client->curl || !local_path || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		ftp_upload_source_t source;
+		int result = upload_source_open(client, local_path, &source);
+		if (result != FTP_OK)
+		{
+			return result;
+		}
+		int64_t file_size = source.size;
+
+		/* The offset must be the server's current size; a stale cached one would append at the wrong place.
+		 * Only a missing file or a server without SIZE means starting from the beginning; any other
+		 * failure could overwrite what is already uploaded */
+		int64_t remote_size = 0;
+		int64_t remote_mtime;
+		result = query_file_info(client, remote_path, &remote_size, &remote_mtime);
+		if (result != FTP_OK && result != FTP_ERROR_FILE_NOT_FOUND)
+		{
+			upload_source_close(&source);
+			return result;
+		}
+		if (result != FTP_OK || remote_size < 0 || remote_size > file_size)
+		{
+			remote_size = 0;
+		}
+
+		if (remote_size > 0 && remote_size == file_size)
+		{
+			upload_source_close(&source);
+			return FTP_OK;
+		}
+
+		if (upload_source_seek(&source, remote_size) != 0)
+		{
+			upload_source_close(&source);
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot seek in local file: %s", local_path);
+			return FTP_ERROR_FILE_IO;
+		}
+
+		result = upload_source_send(client, &source, file_size - remote_size, remote_path, remote_size > 0);
+		upload_source_close(&source);
+		cache_file_written(client, remote_path, result == FTP_OK ? file_size : -1);
+		return result;
+	}
+
+	/* Local file a download is written to */
+	typedef struct
+	{
+		FILE *fp;
+		CURL *curl;
+		int preallocate;
+		int sized;		 /* Announced size already checked */
+		int preallocated;
+		int no_space;
+		int64_t needed;	 /* Announced size, 0 if unknown */
+		int64_t written;
+	} ftp_download_file_t;
+
+	static size_t write_download_file_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		ftp_download_file_t *file = (ftp_download_file_t *)stream;
+
+		if (!file->sized)
+		{
+			file->sized = 1;
+			curl_off_t length = -1;
+			if (file->preallocate &&
+				curl_easy_getinfo(file->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length > 0)
+			{
+				file->needed = (int64_t)length;
+				int reserved = ftp_file_preallocate(ftp_stream_fd(file->fp), file->needed);
+				if (reserved == -2)
+				{
+					file->no_space = 1;
+					return 0;
+				}
+				file->preallocated = reserved == 0;
+			}
+		}
+
+		size_t written = fwrite(ptr, size, nmemb, file->fp);
+		file->written += (int64_t)written;
+		return written;
+	}
+
+	/* Drop reserved space beyond the received data and close the file */
+	static void close_download_file(ftp_download_file_t *file)
+	{
+		if (file->preallocated)
+		{
+			fflush(file->fp);
+			ftp_file_truncate(ftp_stream_fd(file->fp), file->written);
+		}
+		fclose(file->fp);
+		file->fp = NULL;
+	}
+
+	int ftp_client_download(ftp_client_t *client, const char *remote_path, const char *local_path)
+	{
+		if (!client || !client->curl || !local_path || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		/* In resume mode data goes to "<local_path>.part" until the download completes */
+		int resume = client->config.resume_downloads;
+		char *part_path = NULL;
+		if (resume)
+		{
+			size_t path_len = strlen(local_path);
+			part_path = (char *)malloc(path_len + sizeof(".part"));
+			if (!part_path)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for path");
+				return FTP_ERROR_MEMORY;
+			}
+			memcpy(part_path, local_path, path_len);
+			memcpy(part_path + path_len, ".part", sizeof(".part"));
+		}
+
+		/* In atomic mode data goes to a fresh temporary file next to local_path */
+		FILE *fp;
+		if (!resume && client->config.atomic_downloads)
+		{
+			fp = ftp_file_create_temp(local_path, &part_path);
+			if (!fp)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Cannot create temporary file for %s",
+						 local_path);
+				return FTP_ERROR_FILE_IO;
+			}
+		}
+		else
+		{
+			fp = fopen(resume ? part_path : local_path, resume ? "ab" : "wb");
+		}
+
+		const char *write_path = part_path ? part_path : local_path;
+		if (!fp)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot create local file: %s", write_path);
+			free(part_path);
+			return FTP_ERROR_FILE_IO;
+		}
+
+		int64_t resume_from = 0;
+		if (resume && get_local_file_size(fp, &resume_from) != 0)
+		{
+			fclose(fp);
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine size of %s", part_path);
+			free(part_path);
+			return FTP_ERROR_FILE_IO;
+		}
+
+		/* Reset curl handle to default state. MODE Z cannot resume at an offset: curl only sends
+		 * REST when it can check the received length against the uncompressed size */
+		prepare_transfer_handle(client, resume_from == 0);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			fclose(fp);
+			if (!resume && part_path)
+			{
+				remove(part_path);
+			}
+			free(part_path);
+			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
+			return result;
+		}
+
+		char *stdio_buffer = ftp_file_prepare_stream(fp, client->config.file_buffer_size);
+
+		/* The size of a partial file marks where to resume, so it is never extended ahead of the data */
+		ftp_download_file_t file;
+		memset(&file, 0, sizeof(file));
+		file.fp = fp;
+		file.curl = client->curl;
+		file.preallocate = client->config.preallocate_downloads && !resume;
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		set_transfer_callback(client, 0, write_download_file_callback, &file);
+		curl_easy_setopt(client->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)resume_from);
+
+		CURLcode res = perform_curl(client);
+
+		if (res == CURLE_BAD_DOWNLOAD_RESUME && resume_from > 0)
+		{
+			/* The partial file is larger than the remote file, so it is stale */
+			close_download_file(&file);
+			free(stdio_buffer);
+			fp = fopen(write_path, "wb");
+			if (!fp)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Cannot create local file: %s", write_path);
+				free(part_path);
+				return FTP_ERROR_FILE_IO;
+			}
+			stdio_buffer = ftp_file_prepare_stream(fp, client->config.file_buffer_size);
+			file.fp = fp;
+			file.sized = 0;
+			file.written = 0;
+			set_transfer_callback(client, 0, write_download_file_callback, &file); /* Restart the checksums */
+			curl_easy_setopt(client->curl, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)0);
+			res = perform_curl(client);
+		}
+
+		/* Data first, then the rename that publishes it */
+		int sync_failed = 0;
+		if (res == CURLE_OK && client->config.fsync_policy != FTP_FSYNC_NONE)
+		{
+			sync_failed = fflush(file.fp) != 0 || ftp_file_sync(ftp_stream_fd(file.fp)) != 0;
+		}
+
+		close_download_file(&file);
+		free(stdio_buffer);
+
+		if (res != CURLE_OK)
+		{
+			if (file.no_space)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Not enough disk space for %s (%lld bytes)",
+						 write_path, (long long)file.needed);
+			}
+			else
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Download failed: %s",
+						 download_error_text(client, res));
+			}
+			if (!resume)
+			{
+				remove(write_path); /* Delete partial file */
+			}
+			free(part_path);
+
+			if (file.no_space)
+			{
+				return FTP_ERROR_FILE_IO;
+			}
+			if (res == CURLE_REMOTE_FILE_NOT_FOUND)
+			{
+				return FTP_ERROR_FILE_NOT_FOUND;
+			}
+			return FTP_ERROR_TRANSFER;
+		}
+
+		if (sync_failed)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot flush %s to disk", write_path);
+			if (!resume)
+			{
+				remove(write_path);
+			}
+			free(part_path);
+			return FTP_ERROR_FILE_IO;
+		}
+
+		if (part_path && replace_local_file(part_path, local_path) != 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot rename %s to %s", part_path, local_path);
+			if (!resume)
+			{
+				remove(part_path);
+			}
+			free(part_path);
+			return FTP_ERROR_FILE_IO;
+		}
+		free(part_path);
+
+		if (client->config.fsync_policy == FTP_FSYNC_FILE_AND_DIR && ftp_dir_sync(local_path) != 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot flush directory of %s to disk",
+					 local_path);
+			return FTP_ERROR_FILE_IO;
+		}
+		return FTP_OK;
+	}
+
+	/* Download into memory; the buffer is sized from the announced file size when there is one */
+	typedef struct
+	{
+		CURL *curl;
+		char *data;
+		size_t size;
+		size_t capacity;
+		int fixed;	   /* Caller-provided buffer that must not be reallocated */
+		int sized;	   /* Announced size already checked */
+		int overflow;  /* Fixed buffer too small */
+		size_t needed; /* Announced size, 0 if unknown */
+	} ftp_download_buffer_t;
+
+	static size_t write_download_buffer_callback(void *contents, size_t size, size_t nmemb, void *userp)
+	{
+		size_t realsize = size * nmemb;
+		ftp_download_buffer_t *buffer = (ftp_download_buffer_t *)userp;
+
+		/* Room for the terminating NUL of an allocated buffer */
+		size_t reserve = buffer->fixed ? 0 : 1;
+
+		if (!buffer->sized)
+		{
+			buffer->sized = 1;
+			curl_off_t length = -1;
+			if (curl_easy_getinfo(buffer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK &&
+				length > 0 && (uint64_t)length < (uint64_t)SIZE_MAX)
+			{
+				buffer->needed = (size_t)length;
+				if (buffer->fixed && buffer->needed > buffer->capacity)
+				{
+					buffer->overflow = 1;
+					return 0;
+				}
+				if (!buffer->fixed && buffer->needed + reserve > buffer->capacity)
+				{
+					char *data = (char *)realloc(buffer->data, buffer->needed + reserve);
+					if (!data)
+					{
+						return 0;
+					}
+					buffer->data = data;
+					buffer->capacity = buffer->needed + reserve;
+				}
+			}
+		}
+
+		if (buffer->size + realsize + reserve > buffer->capacity)
+		{
+			if (buffer->fixed)
+			{
+				buffer->overflow = 1;
+				return 0;
+			}
+
+			/* No size announced, or the file grew while being read */
+			size_t new_capacity = buffer->capacity == 0 ? FTP_BUFFER_SIZE : buffer->capacity * 2;
+			while (new_capacity < buffer->size + realsize + reserve)
+			{
+				new_capacity *= 2;
+			}
+
+			char *data = (char *)realloc(buffer->data, new_capacity);
+			if (!data)
+			{
+				return 0;
+			}
+			buffer->data = data;
+			buffer->capacity = new_capacity;
+		}
+
+		memcpy(buffer->data + buffer->size, contents, realsize);
+		buffer->size += realsize;
+		return realsize;
+	}
+
+	static int download_to_buffer(ftp_client_t *client, const char *remote_path, ftp_download_buffer_t *buffer)
+	{
+		/* Reset curl handle to default state */
+		prepare_transfer_handle(client, 1);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
+			return result;
+		}
+
+		buffer->curl = client->curl;
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		set_transfer_callback(client, 0, write_download_buffer_callback, buffer);
+
+		CURLcode res = perform_curl(client);
+
+		if (res == CURLE_WRITE_ERROR && buffer->overflow)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Buffer of %lu bytes too small for %s",
+					 (unsigned long)buffer->capacity, remote_path);
+			return FTP_ERROR_MEMORY;
+		}
+		if (res == CURLE_WRITE_ERROR && !buffer->fixed)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for download");
+			return FTP_ERROR_MEMORY;
+		}
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Download failed: %s", download_error_text(client, res));
+			return res == CURLE_REMOTE_FILE_NOT_FOUND ? FTP_ERROR_FILE_NOT_FOUND : FTP_ERROR_TRANSFER;
+		}
+		return FTP_OK;
+	}
+
+	int ftp_client_download_to_memory(ftp_client_t *client, const char *remote_path, char **data, size_t *size)
+	{
+		if (!client || !client->curl || !remote_path || !data || !size)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		*data = NULL;
+		*size = 0;
+
+		ftp_download_buffer_t buffer;
+		memset(&buffer, 0, sizeof(buffer));
+		int result = download_to_buffer(client, remote_path, &buffer);
+		if (result == FTP_OK && !buffer.data)
+		{
+			/* Empty file */
+			buffer.data = (char *)malloc(1);
+			if (!buffer.data)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for download");
+				result = FTP_ERROR_MEMORY;
+			}
+		}
+		if (result != FTP_OK)
+		{
+			free(buffer.data);
+			return result;
+		}
+
+		buffer.data[buffer.size] = '\0';
+		*data = buffer.data;
+		*size = buffer.size;
+		return FTP_OK;
+	}
+
+	int ftp_client_download_to_buffer(ftp_client_t *client, const char *remote_path, void *buffer, size_t capacity,
+									  size_t *size)
+	{
+		if (!client || !client->curl || !remote_path || !buffer || !size)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		ftp_download_buffer_t target;
+		memset(&target, 0, sizeof(target));
+		target.data = (char *)buffer;
+		target.capacity = capacity;
+		target.fixed = 1;
+
+		int result = download_to_buffer(client, remote_path, &target);
+		*size = result == FTP_OK ? target.size : (target.overflow ? target.needed : 0);
+		return result;
+	}
+
+	/* Download into a user sink */
+	typedef struct
+	{
+		ftp_client_t *client;
+		ftp_sink_callback_t sink;
+		void *user_data;
+		int paused;
+		int aborted;
+	} ftp_download_sink_t;
+
+	static size_t write_sink_callback(void *contents, size_t size, size_t nmemb, void *userp)
+	{
+		ftp_download_sink_t *sink = (ftp_download_sink_t *)userp;
+		size_t realsize = size * nmemb;
+
+		int action = sink->sink(sink->user_data, contents, realsize);
+		if (action == FTP_SINK_CONTINUE)
+		{
+			return realsize;
+		}
+		if (action == FTP_SINK_PAUSE)
+		{
+			sink->paused = 1;
+			return CURL_WRITEFUNC_PAUSE;
+		}
+		sink->aborted = 1;
+		return 0;
+	}
+
+	/* Unpause from libcurl's own thread; the held block is offered again from inside curl_easy_pause() */
+	static int sink_progress_callback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal,
+									  curl_off_t ulnow)
+	{
+		ftp_download_sink_t *sink = (ftp_download_sink_t *)clientp;
+		if (sink->paused)
+		{
+			sink->paused = 0;
+			curl_easy_pause(sink->client->curl, CURLPAUSE_CONT);
+		}
+		return progress_callback_wrapper(sink->client, dltotal, dlnow, ultotal, ulnow);
+	}
+
+	int ftp_client_download_to_callback(ftp_client_t *client, const char *remote_path, ftp_sink_callback_t sink,
+										void *user_data)
+	{
+		if (!client || !client->curl || !remote_path || !sink)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		/* Reset curl handle to default state */
+		prepare_transfer_handle(client, 1);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
+			return result;
+		}
+
+		ftp_download_sink_t target;
+		target.client = client;
+		target.sink = sink;
+		target.user_data = user_data;
+		target.paused = 0;
+		target.aborted = 0;
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		set_transfer_callback(client, 0, write_sink_callback, &target);
+
+		/* The progress callback is what resumes a paused transfer */
+		curl_easy_setopt(client->curl, CURLOPT_XFERINFOFUNCTION, sink_progress_callback);
+		curl_easy_setopt(client->curl, CURLOPT_XFERINFODATA, &target);
+		curl_easy_setopt(client->curl, CURLOPT_NOPROGRESS, 0L);
+
+		CURLcode res = perform_curl(client);
+
+		/* Later operations on a kept session must not see this sink */
+		setup_progress_callback(client, client->curl);
+
+		if (target.aborted)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Download aborted by callback");
+			return FTP_ERROR_TRANSFER;
+		}
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Download failed: %s", download_error_text(client, res));
+			return res == CURLE_REMOTE_FILE_NOT_FOUND ? FTP_ERROR_FILE_NOT_FOUND : FTP_ERROR_TRANSFER;
+		}
+		return FTP_OK;
+	}
+
+	/* Parallel segmented download */
+
+	typedef struct ftp_download_segment ftp_download_segment_t;
+
+	typedef struct
+	{
+		ftp_client_t *client;
+		const char *remote_path;
+		int fd;
+		int64_t total_size;
+		ftp_download_segment_t *segments;
+		int segment_count;
+		ftp_mutex_t mutex;
+		int aborted;
+		int failed_segment; /* Index of the first segment that failed, -1 if none */
+	} ftp_parallel_download_t;
+
+	struct ftp_download_segment
+	{
+		ftp_parallel_download_t *shared;
+		ftp_client_t *session;
+		int64_t start;
+		int64_t end;	/* Last byte of the range (inclusive) */
+		int64_t offset; /* Next file offset to write */
+		int io_error;
+		int result;
+		ftp_thread_t thread;
+	};
+
+	static size_t segment_write_callback(void *ptr, size_t size, size_t nmemb, void *userp)
+	{
+		ftp_download_segment_t *segment = (ftp_download_segment_t *)userp;
+		size_t realsize = size * nmemb;
+
+		/* Never write past the end of the range even if the server sends more */
+		int64_t remaining = segment->end + 1 - segment->offset;
+		size_t to_write = (int64_t)realsize > remaining ? (size_t)remaining : realsize;
+
+		if (to_write > 0 && ftp_file_pwrite(segment->shared->fd, ptr, to_write, segment->offset) != 0)
+		{
+			segment->io_error = 1;
+			return 0;
+		}
+
+		ftp_mutex_lock(&segment->shared->mutex);
+		segment->offset += (int64_t)to_write;
+		ftp_mutex_unlock(&segment->shared->mutex);
+		return realsize;
+	}
+
+	static int segment_progress_callback(void *user_data, double download_total, double download_now,
+										 double upload_total, double upload_now)
+	{
+		ftp_download_segment_t *segment = (ftp_download_segment_t *)user_data;
+		ftp_parallel_download_t *shared = segment->shared;
+		ftp_client_t *client = shared->client;
+		(void)download_total;
+		(void)download_now;
+		(void)upload_total;
+		(void)upload_now;
+
+		/* Report the combined progress of all segments, one callback at a time */
+		ftp_mutex_lock(&shared->mutex);
+		if (!shared->aborted && client->config.progress_callback)
+		{
+			int64_t received = 0;
+			for (int i = 0; i < shared->segment_count; i++)
+			{
+				received += shared->segments[i].offset - shared->segments[i].start;
+			}
+			if (client->config.progress_callback(client->config.progress_user_data, (double)shared->total_size,
+												 (double)received, 0.0, 0.0) != 0)
+			{
+				shared->aborted = 1;
+			}
+		}
+		int aborted = shared->aborted;
+		ftp_mutex_unlock(&shared->mutex);
+		return aborted;
+	}
+
+	/* Fetch one byte range over the segment's own session */
+	static int segment_download(ftp_download_segment_t *segment)
+	{
+		ftp_client_t *session = segment->session;
+
+		prepare_curl_handle(session);
+
+		char url[FTP_MAX_URL_LENGTH];
+		char range[64];
+		if (build_ftp_url(session, segment->shared->remote_path, url, sizeof(url)) != FTP_OK)
+		{
+			snprintf(session->last_error, sizeof(session->last_error), "Remote path too long");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+		snprintf(range, sizeof(range), "%lld-%lld", (long long)segment->start, (long long)segment->end);
+
+		curl_easy_setopt(session->curl, CURLOPT_URL, url);
+		curl_easy_setopt(session->curl, CURLOPT_RANGE, range);
+		set_transfer_callback(session, 0, segment_write_callback, segment);
+
+		/* All segments count against the limits of the client that started the download */
+		if (session->throttle_state)
+		{
+			session->throttle_state->client = segment->shared->client;
+		}
+
+		CURLcode res = perform_curl(session);
+
+		if (segment->io_error)
+		{
+			snprintf(session->last_error, sizeof(session->last_error), "Cannot write to local file");
+			return FTP_ERROR_FILE_IO;
+		}
+		if (res != CURLE_OK)
+		{
+			snprintf(session->last_error, sizeof(session->last_error), "Download failed: %s",
+					 curl_easy_strerror(res));
+			return res == CURLE_REMOTE_FILE_NOT_FOUND ? FTP_ERROR_FILE_NOT_FOUND : FTP_ERROR_TRANSFER;
+		}
+		if (segment->offset != segment->end + 1)
+		{
+			snprintf(session->last_error, sizeof(session->last_error), "Download failed: segment ended early");
+			return FTP_ERROR_TRANSFER;
+		}
+		return FTP_OK;
+	}
+
+	static FTP_THREAD_PROC(segment_download_thread)
+	{
+		ftp_download_segment_t *segment = (ftp_download_segment_t *)arg;
+
+		segment->result = segment_download(segment);
+		if (segment->result != FTP_OK)
+		{
+			/* Stop the other segments early */
+			ftp_mutex_lock(&segment->shared->mutex);
+			segment->shared->aborted = 1;
+			if (segment->shared->failed_segment < 0)
+			{
+				segment->shared->failed_segment = (int)(segment - segment->shared->segments);
+			}
+			ftp_mutex_unlock(&segment->shared->mutex);
+		}
+
+		FTP_THREAD_RETURN;
+	}
+
+	int ftp_client_download_parallel(ftp_client_t *client, const char *remote_path, const char *local_path,
+									 int nsegments)
+	{
+		if (!client || !client->curl || !remote_path || !local_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		/* Size the ranges from the server's current length, not the metadata cache */
+		int64_t file_size, file_time;
+		int result = query_file_info(client, remote_path, &file_size, &file_time);
+		if (result != FTP_OK)
+		{
+			return result;
+		}
+		if (file_size < 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Could not retrieve file size");
+			return FTP_ERROR_TRANSFER;
+		}
+
+		/* Keep every segment at least FTP_MIN_SEGMENT_SIZE bytes */
+		int64_t max_segments = file_size / FTP_MIN_SEGMENT_SIZE;
+		if (nsegments > max_segments)
+		{
+			nsegments = (int)max_segments;
+		}
+		if (nsegments <= 1)
+		{
+			return ftp_client_download(client, remote_path, local_path);
+		}
+
+		/* Segments arrive out of order and are not hashed; report no checksums rather than stale ones */
+		if (client->checksum_state)
+		{
+			client->checksum_state->types = 0;
+		}
+
+		ftp_parallel_download_t shared;
+		memset(&shared, 0, sizeof(shared));
+		shared.client = client;
+		shared.remote_path = remote_path;
+		shared.total_size = file_size;
+		shared.segment_count = nsegments;
+		shared.failed_segment = -1;
+		shared.segments = (ftp_download_segment_t *)calloc((size_t)nsegments, sizeof(ftp_download_segment_t));
+		if (!shared.segments)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate download segments");
+			return FTP_ERROR_MEMORY;
+		}
+
+		/* Reserve the whole file before the segments write into it at scattered offsets, so it is
+		 * not fragmented and a full disk fails now; truncating sets the size where that is unsupported */
+		int reserved = -1;
+		shared.fd = ftp_file_open(local_path, O_WRONLY | O_CREAT | O_TRUNC);
+		if (shared.fd >= 0)
+		{
+			reserved = ftp_file_preallocate(shared.fd, file_size);
+		}
+		if (shared.fd < 0 || reserved == -2 || ftp_file_truncate(shared.fd, file_size) != 0)
+		{
+			if (shared.fd >= 0)
+			{
+				ftp_file_close(shared.fd);
+				remove(local_path);
+			}
+			free(shared.segments);
+			if (reserved == -2)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Not enough disk space for %s (%lld bytes)",
+						 local_path, (long long)file_size);
+			}
+			else
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Cannot create local file: %s", local_path);
+			}
+			return FTP_ERROR_FILE_IO;
+		}
+
+		ftp_mutex_init(&shared.mutex);
+
+		/* Split the file into nearly equal ranges and start one session per range */
+		int64_t segment_size = file_size / nsegments;
+		int started = 0;
+		result = FTP_OK;
+		for (int i = 0; i < nsegments; i++)
+		{
+			ftp_download_segment_t *segment = &shared.segments[i];
+			segment->shared = &shared;
+			segment->start = (int64_t)i * segment_size;
+			segment->end = i == nsegments - 1 ? file_size - 1 : segment->start + segment_size - 1;
+			segment->offset = segment->start;
+			segment->session = ftp_client_duplicate(client);
+			if (!segment->session)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate download session");
+				result = FTP_ERROR_MEMORY;
+				break;
+			}
+			segment->session->config.checksum_types = FTP_CHECKSUM_NONE;
+			segment->session->config.progress_callback = segment_progress_callback;
+			segment->session->config.progress_user_data = segment;
+		}
+
+		for (int i = 0; result == FTP_OK && i < nsegments; i++)
+		{
+			if (ftp_thread_create(&shared.segments[i].thread, segment_download_thread, &shared.segments[i]) != 0)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to start download thread");
+				result = FTP_ERROR_MEMORY;
+				ftp_mutex_lock(&shared.mutex);
+				shared.aborted = 1;
+				ftp_mutex_unlock(&shared.mutex);
+				break;
+			}
+			started++;
+		}
+
+		for (int i = 0; i < started; i++)
+		{
+			ftp_thread_join(shared.segments[i].thread);
+		}
+
+		/* Report the segment that failed first; the others were aborted because of it */
+		if (result == FTP_OK && shared.failed_segment >= 0)
+		{
+			ftp_download_segment_t *failed = &shared.segments[shared.failed_segment];
+			result = failed->result;
+			snprintf(client->last_error, sizeof(client->last_error), "%s", failed->session->last_error);
+		}
+
+		/* Segments run side by side, so their statistics describe one download */
+		ftp_transfer_stats_t *combined = &client->transfer_stats;
+		memset(combined, 0, sizeof(*combined));
+		for (int i = 0; i < started; i++)
+		{
+			merge_transfer_stats(combined, &shared.segments[i].session->transfer_stats);
+		}
+
+		for (int i = 0; i < nsegments; i++)
+		{
+			ftp_client_destroy(shared.segments[i].session);
+		}
+
+		if (ftp_file_close(shared.fd) != 0 && result == FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Cannot write to local file");
+			result = FTP_ERROR_FILE_IO;
+		}
+		ftp_mutex_destroy(&shared.mutex);
+		free(shared.segments);
+
+		if (result != FTP_OK)
+		{
+			remove(local_path); /* Delete partial file */
+		}
+		return result;
+	}
+
+	int ftp_client_list_dir(ftp_client_t *client, const char *remote_path, char **output)
+	{
+		if (!client || !client->curl || !remote_path || !output)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		char *cached = cache_lookup_listing(client, remote_path);
+		if (cached)
+		{
+			*output = cached;
+			return FTP_OK;
+		}
+
+		/* Reset curl handle to default state */
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_dir_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Directory path too long");
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+
+		ftp_memory_buffer_t buffer = {0};
+		set_reply_callback(client, write_memory_callback, &buffer);
+
+		CURLcode res = perform_curl(client);
+
+		if (res != CURLE_OK)
+		{
+			if (buffer.data)
+			{
+				free(buffer.data);
+			}
+			snprintf(client->last_error, sizeof(client->last_error), "Directory listing failed: %s",
+					 curl_easy_strerror(res));
+			return FTP_ERROR_TRANSFER;
+		}
+
+		if (buffer.data)
+		{
+			cache_store_listing(client, remote_path, buffer.data);
+		}
+		*output = buffer.data;
+		return FTP_OK;
+	}
+
+	/* Days since 1970-01-01 for a proleptic Gregorian date */
+	static int64_t days_from_civil(int64_t year, int month, int day)
+	{
+		year -= month <= 2;
+		int64_t era = (year >= 0 ? year : year - 399) / 400;
+		int64_t year_of_era = year - era * 400;
+		int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+		return era * 146097 + day_of_era - 719468;
+	}
+
+	/* Parse an MLSD time value "YYYYMMDDHHMMSS[.sss]" (UTC); -1 if malformed */
+	static int64_t parse_mlsd_time(const char *value, size_t len)
+	{
+		static const int widths[6] = {4, 2, 2, 2, 2, 2};
+		int parts[6];
+		size_t pos = 0;
+		int i, j;
+
+		if (len < 14)
+		{
+			return -1;
+		}
+		for (i = 0; i < 6; i++)
+		{
+			parts[i] = 0;
+			for (j = 0; j < widths[i]; j++, pos++)
+			{
+				if (!isdigit((unsigned char)value[pos]))
+				{
+					return -1;
+				}
+				parts[i] = parts[i] * 10 + (value[pos] - '0');
+			}
+		}
+		if (parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31)
+		{
+			return -1;
+		}
+
+		return days_from_civil(parts[0], parts[1], parts[2]) * 86400 + parts[3] * 3600 + parts[4] * 60 + parts[5];
+	}
+
+	/* Parse one MLSD line in place; the name is NUL-terminated inside the line. Returns 0 to skip the line. */
+	static int parse_mlsd_line(char *line, size_t len, ftp_entry_t *entry)
+	{
+		/* "fact=value;fact=value; name" - the facts never contain a space */
+		char *space = (char *)memchr(line, ' ', len);
+		if (!space || space + 1 == line + len)
+		{
+			return 0;
+		}
+
+		entry->name = space + 1;
+		entry->type = FTP_ENTRY_UNKNOWN;
+		entry->size = -1;
+		entry->modify_time = -1;
+		entry->perms = -1;
+		line[len] = '\0';
+
+		char *fact = line;
+		while (fact < space)
+		{
+			char *end = (char *)memchr(fact, ';', (size_t)(space - fact));
+			if (!end)
+			{
+				end = space;
+			}
+			char *eq = (char *)memchr(fact, '=', (size_t)(end - fact));
+			if (eq)
+			{
+				size_t name_len = (size_t)(eq - fact);
+				const char *value = eq + 1;
+				size_t value_len = (size_t)(end - value);
+
+				if (token_equals(fact, name_len, "type"))
+				{
+					if (token_equals(value, value_len, "file"))
+					{
+						entry->type = FTP_ENTRY_FILE;
+					}
+					else if (token_equals(value, value_len, "dir"))
+					{
+						entry->type = FTP_ENTRY_DIR;
+					}
+					else if (token_equals(value, value_len, "cdir") || token_equals(value, value_len, "pdir"))
+					{
+						return 0;
+					}
+					else if (value_len >= 13 && (token_equals(value, 13, "OS.unix=slink") ||
+												 token_equals(value, value_len, "OS.unix=symlink")))
+					{
+						entry->type = FTP_ENTRY_LINK;
+					}
+				}
+				else if (token_equals(fact, name_len, "size") || token_equals(fact, name_len, "sizd"))
+				{
+					entry->size = (int64_t)strtoll(value, NULL, 10);
+				}
+				else if (token_equals(fact, name_len, "modify"))
+				{
+					entry->modify_time = parse_mlsd_time(value, value_len);
+				}
+				else if (token_equals(fact, name_len, "UNIX.mode"))
+				{
+					entry->perms = (int)(strtol(value, NULL, 8) & 07777);
+				}
+			}
+			fact = end + 1;
+		}
+
+		return 1;
+	}
+
+	/* Vectorized newline scanning for large listings */
+
+	static unsigned int lowest_bit_index(unsigned int mask)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return (unsigned int)__builtin_ctz(mask);
+#else
+		unsigned int index = 0;
+		while (!(mask & 1u))
+		{
+			mask >>= 1;
+			index++;
+		}
+		return index;
+#endif
+	}
+
+	static size_t count_bits(unsigned int mask)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return (size_t)__builtin_popcount(mask);
+#else
+		size_t count = 0;
+		while (mask)
+		{
+			mask &= mask - 1;
+			count++;
+		}
+		return count;
+#endif
+	}
+
+	/* Return the first '\n' in [p, end), or NULL */
+	static const char *find_newline(const char *p, const char *end)
+	{
+#if defined(FTP_HAVE_AVX2)
+		const __m256i newline = _mm256_set1_epi8('\n');
+		while (end - p >= 32)
+		{
+			__m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+			unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+			if (mask)
+			{
+				return p + lowest_bit_index(mask);
+			}
+			p += 32;
+		}
+#elif defined(FTP_HAVE_SSE2)
+		const __m128i newline = _mm_set1_epi8('\n');
+		while (end - p >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i *)p);
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+			if (mask)
+			{
+				return p + lowest_bit_index(mask);
+			}
+			p += 16;
+		}
+#endif
+		return p < end ? (const char *)memchr(p, '\n', (size_t)(end - p)) : NULL;
+	}
+
+	static size_t count_newlines(const char *p, const char *end)
+	{
+		size_t count = 0;
+#if defined(FTP_HAVE_AVX2)
+		const __m256i newline = _mm256_set1_epi8('\n');
+		for (; end - p >= 32; p += 32)
+		{
+			__m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+			count += count_bits((unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+		}
+#elif defined(FTP_HAVE_SSE2)
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; end - p >= 16; p += 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i *)p);
+			count += count_bits((unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+		}
+#endif
+		for (; p < end; p++)
+		{
+			count += *p == '\n';
+		}
+		return count;
+	}
+
+	/* LIST output parsing */
+
+	/* Split the next whitespace-delimited field off [*p, end) */
+	static int next_field(char **p, char *end, char **field, size_t *len)
+	{
+		char *s = *p;
+		while (s < end && (*s == ' ' || *s == '\t'))
+		{
+			s++;
+		}
+		char *e = s;
+		while (e < end && *e != ' ' && *e != '\t')
+		{
+			e++;
+		}
+		*field = s;
+		*len = (size_t)(e - s);
+		*p = e;
+		return e > s;
+	}
+
+	static int parse_small_number(const char *s, size_t len, int *value)
+	{
+		size_t i;
+		*value = 0;
+		if (len == 0 || len > 9)
+		{
+			return 0;
+		}
+		for (i = 0; i < len; i++)
+		{
+			if (!isdigit((unsigned char)s[i]))
+			{
+				return 0;
+			}
+			*value = *value * 10 + (s[i] - '0');
+		}
+		return 1;
+	}
+
+	static int parse_month_name(const char *s, size_t len)
+	{
+		/* Compare all three letters at once; | 0x20 folds ASCII letters to lower case */
+		static const uint32_t months[12] = {0x6a616e, 0x666562, 0x6d6172, 0x617072, 0x6d6179, 0x6a756e,
+											0x6a756c, 0x617567, 0x736570, 0x6f6374, 0x6e6f76, 0x646563};
+		int i;
+		if (len != 3)
+		{
+			return 0;
+		}
+		uint32_t key = ((uint32_t)(unsigned char)(s[0] | 0x20) << 16) | ((uint32_t)(unsigned char)(s[1] | 0x20) << 8) |
+					   (uint32_t)(unsigned char)(s[2] | 0x20);
+		for (i = 0; i < 12; i++)
+		{
+			if (key == months[i])
+			{
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+	/* Unix permission bits from "rwxr-xr-x", including setuid, setgid and sticky */
+	static int parse_unix_perms(const char *s)
+	{
+		int perms = 0;
+		int i;
+		for (i = 0; i < 3; i++)
+		{
+			const char *group = s + i * 3;
+			int shift = 6 - i * 3;
+			if (group[0] == 'r')
+			{
+				perms |= 4 << shift;
+			}
+			if (group[1] == 'w')
+			{
+				perms |= 2 << shift;
+			}
+			if (group[2] == 'x' || group[2] == 's' || group[2] == 't')
+			{
+				perms |= 1 << shift;
+			}
+			if (group[2] == 's' || group[2] == 'S')
+			{
+				perms |= i == 0 ? 04000 : 02000;
+			}
+			else if (i == 2 && (group[2] == 't' || group[2] == 'T'))
+			{
+				perms |= 01000;
+			}
+		}
+		return perms;
+	}
+
+	/* The "16 01:50" or "16 2020" after the month; leaves *p alone unless both fields match */
+	static int parse_unix_day_time(char **p, char *end, int *day, int *year, int *hour, int *minute)
+	{
+		char *q = *p;
+		char *field;
+		size_t field_len;
+
+		if (!next_field(&q, end, &field, &field_len) || !parse_small_number(field, field_len, day))
+		{
+			return 0;
+		}
+		if (!next_field(&q, end, &field, &field_len))
+		{
+			return 0;
+		}
+		if (parse_small_number(field, field_len, year))
+		{
+			*hour = *minute = 0;
+		}
+		else if (field_len == 5 && field[2] == ':' && parse_small_number(field, 2, hour) &&
+				 parse_small_number(field + 3, 2, minute))
+		{
+			*year = 0; /* Recent entry without a year */
+		}
+		else
+		{
+			return 0;
+		}
+		*p = q;
+		return 1;
+	}
+
+	/* "-rw-r--r-- 1 owner group 1234 Oct 16 01:50 name"; the group column may be missing */
+	static int parse_unix_list_line(char *line, size_t len, ftp_entry_t *entry, int64_t now)
+	{
+		char *end = line + len;
+		char *p = line;
+		char *field;
+		size_t field_len;
+
+		if (!next_field(&p, end, &field, &field_len) || field_len < 10)
+		{
+			return 0;
+		}
+		switch (field[0])
+		{
+		case '-':
+			entry->type = FTP_ENTRY_FILE;
+			break;
+		case 'd':
+			entry->type = FTP_ENTRY_DIR;
+			break;
+		case 'l':
+			entry->type = FTP_ENTRY_LINK;
+			break;
+		default:
+			entry->type = FTP_ENTRY_UNKNOWN;
+			break;
+		}
+		entry->perms = parse_unix_perms(field + 1);
+
+		/* The size is the field right before the month name. Owners and groups such as
+		 * "may" look like months, so a month only counts when a day and time follow */
+		char *size_field = NULL;
+		int month = 0;
+		int fields = 0;
+		int day = 0, year = 0, hour = 0, minute = 0;
+		while (fields < 6 && next_field(&p, end, &field, &field_len))
+		{
+			month = parse_month_name(field, field_len);
+			if (month && size_field && parse_unix_day_time(&p, end, &day, &year, &hour, &minute))
+			{
+				break;
+			}
+			month = 0;
+			size_field = field;
+			fields++;
+		}
+		if (!month)
+		{
+			return 0;
+		}
+		int has_year = year != 0;
+
+		/* The name is the rest of the line after one separator; it may contain spaces */
+		if (p >= end)
+		{
+			return 0;
+		}
+		p++;
+		*end = '\0';
+		if (entry->type == FTP_ENTRY_LINK)
+		{
+			char *arrow = strstr(p, " -> ");
+			if (arrow)
+			{
+				*arrow = '\0';
+			}
+		}
+		if (*p == '\0')
+		{
+			return 0;
+		}
+		entry->name = p;
+
+		entry->size = (int64_t)strtoll(size_field, NULL, 10);
+
+		if (!has_year)
+		{
+			/* Recent entries omit the year; pick the one that is not in the future */
+			int64_t days_now = now / 86400;
+			year = (int)(1970 + days_now / 366);
+			while (days_from_civil(year + 1, 1, 1) <= days_now)
+			{
+				year++;
+			}
+			if (days_from_civil(year, month, day) > days_now + 1)
+			{
+				year--;
+			}
+		}
+		entry->modify_time = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+		return 1;
+	}
+
+	/* "10-16-26  01:50PM       <DIR>          name" or with a file size instead of <DIR> */
+	static int parse_dos_list_line(char *line, size_t len, ftp_entry_t *entry)
+	{
+		char *end = line + len;
+		char *p = line;
+		char *field;
+		size_t field_len;
+		int month, day, year, hour, minute;
+
+		if (!next_field(&p, end, &field, &field_len) || (field_len != 8 && field_len != 10) ||
+			(field[2] != '-' && field[2] != '/') || !parse_small_number(field, 2, &month) ||
+			!parse_small_number(field + 3, 2, &day) || !parse_small_number(field + 6, field_len - 6, &year))
+		{
+			return 0;
+		}
+		if (field_len == 8)
+		{
+			year += year < 70 ? 2000 : 1900;
+		}
+
+		if (!next_field(&p, end, &field, &field_len) || field_len < 5 || field[2] != ':' ||
+			!parse_small_number(field, 2, &hour) || !parse_small_number(field + 3, 2, &minute))
+		{
+			return 0;
+		}
+		if (field_len == 7)
+		{
+			int pm = tolower((unsigned char)field[5]) == 'p';
+			hour = hour % 12 + (pm ? 12 : 0);
+		}
+
+		if (!next_field(&p, end, &field, &field_len))
+		{
+			return 0;
+		}
+		if (token_equals(field, field_len, "<DIR>"))
+		{
+			entry->type = FTP_ENTRY_DIR;
+			entry->size = -1;
+		}
+		else
+		{
+			entry->type = FTP_ENTRY_FILE;
+			entry->size = (int64_t)strtoll(field, NULL, 10);
+		}
+
+		while (p < end && (*p == ' ' || *p == '\t'))
+		{
+			p++;
+		}
+		if (p >= end || month < 1 || month > 12)
+		{
+			return 0;
+		}
+		*end = '\0';
+		entry->name = p;
+		entry->perms = -1;
+		entry->modify_time = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60;
+		return 1;
+	}
+
+	static int parse_list_line(char *line, size_t len, ftp_entry_t *entry, int64_t now)
+	{
+		if (len == 0)
+		{
+			return 0;
+		}
+		int parsed = isdigit((unsigned char)line[0]) ? parse_dos_list_line(line, len, entry)
+													: parse_unix_list_line(line, len, entry, now);
+
+		/* Drop "." and ".." like the cdir and pdir facts of MLSD */
+		return parsed && strcmp(entry->name, ".") != 0 && strcmp(entry->name, "..") != 0;
+	}
+
+	/* Parse one MLSD or LIST line in place; line[len] must be writable */
+	static int parse_listing_line(char *line, size_t len, int is_mlsd, ftp_entry_t *entry, int64_t now)
+	{
+		return is_mlsd ? parse_mlsd_line(line, len, entry) : parse_list_line(line, len, entry, now);
+	}
+
+	/* Build an entry list over a downloaded listing; the buffer becomes the name arena */
+	static int build_entry_list(char *data, size_t size, int is_mlsd, ftp_entry_list_t *list)
+	{
+		const char *end = data + size;
+		size_t lines = count_newlines(data, end) + 1;
+
+		list->entries = (ftp_entry_t *)malloc(lines * sizeof(ftp_entry_t));
+		if (!list->entries)
+		{
+			free(data);
+			return FTP_ERROR_MEMORY;
+		}
+		list->arena = data;
+
+		int64_t now = (int64_t)time(NULL);
+		char *line = data;
+		while (line < end)
+		{
+			char *eol = (char *)find_newline(line, end);
+			char *next = eol ? eol + 1 : (char *)end;
+			size_t len = (size_t)((eol ? eol : end) - line);
+			if (len > 0 && line[len - 1] == '\r')
+			{
+				len--;
+			}
+			if (parse_listing_line(line, len, is_mlsd, &list->entries[list->count], now))
+			{
+				list->count++;
+			}
+			line = next;
+		}
+
+		return FTP_OK;
+	}
+
+	/* Retrieve a directory listing with MLSD or LIST, passing the data to write_callback */
+	static int perform_listing(ftp_client_t *client, const char *remote_path, int use_mlsd,
+							   size_t (*write_callback)(void *, size_t, size_t, void *), void *write_data)
+	{
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_dir_url(client, remote_path, url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Directory path too long");
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		if (use_mlsd)
+		{
+			curl_easy_setopt(client->curl, CURLOPT_CUSTOMREQUEST, "MLSD");
+		}
+		set_reply_callback(client, write_callback, write_data);
+
+		CURLcode res = perform_curl(client);
+
+		curl_easy_setopt(client->curl, CURLOPT_CUSTOMREQUEST, NULL);
+
+		if (res != CURLE_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Directory listing failed: %s",
+					 curl_easy_strerror(res));
+			return FTP_ERROR_TRANSFER;
+		}
+
+		return FTP_OK;
+	}
+
+	int ftp_client_list_entries(ftp_client_t *client, const char *remote_path, ftp_entry_list_t *list)
+	{
+		if (!client || !client->curl || !remote_path || !list)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		list->entries = NULL;
+		list->count = 0;
+		list->arena = NULL;
+
+		probe_server_features(client);
+		int use_mlsd = (client->server_features & FTP_FEATURE_MLSD) != 0;
+
+		ftp_memory_buffer_t buffer = {0};
+		int result = perform_listing(client, remote_path, use_mlsd, write_memory_callback, &buffer);
+		if (result != FTP_OK)
+		{
+			if (buffer.data)
+			{
+				free(buffer.data);
+			}
+			return result;
+		}
+
+		if (!buffer.data)
+		{
+			return FTP_OK;
+		}
+
+		result = build_entry_list(buffer.data, buffer.size, use_mlsd, list);
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for entries");
+		}
+		return result;
+	}
+
+	/* Streaming listing state; line holds the current, possibly incomplete, line */
+	typedef struct
+	{
+		ftp_entry_callback_t callback;
+		void *user_data;
+		int is_mlsd;
+		int64_t now;
+		char *line;
+		size_t length;
+		size_t capacity;
+		int aborted;
+		int out_of_memory;
+	} ftp_list_stream_t;
+
+	static int list_stream_append(ftp_list_stream_t *stream, const char *data, size_t size)
+	{
+		/* One spare byte for the terminator the line parsers write */
+		if (stream->length + size + 1 > stream->capacity)
+		{
+			size_t new_capacity = stream->capacity == 0 ? 256 : stream->capacity * 2;
+			while (new_capacity < stream->length + size + 1)
+			{
+				new_capacity *= 2;
+			}
+			char *new_line = (char *)realloc(stream->line, new_capacity);
+			if (!new_line)
+			{
+				stream->out_of_memory = 1;
+				return 0;
+			}
+			stream->line = new_line;
+			stream->capacity = new_capacity;
+		}
+		memcpy(stream->line + stream->length, data, size);
+		stream->length += size;
+		return 1;
+	}
+
+	/* Parse the buffered line and hand it to the callback; returns 0 if the callback stopped the listing */
+	static int list_stream_flush(ftp_list_stream_t *stream)
+	{
+		size_t len = stream->length;
+		ftp_entry_t entry;
+
+		stream->length = 0;
+		if (len > 0 && stream->line[len - 1] == '\r')
+		{
+			len--;
+		}
+		if (parse_listing_line(stream->line, len, stream->is_mlsd, &entry, stream->now) &&
+			stream->callback(stream->user_data, &entry) != 0)
+		{
+			stream->aborted = 1;
+			return 0;
+		}
+		return 1;
+	}
+
+	static size_t list_stream_write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+	{
+		size_t realsize = size * nmemb;
+		ftp_list_stream_t *stream = (ftp_list_stream_t *)userp;
+		const char *p = (const char *)contents;
+		const char *end = p + realsize;
+
+		while (p < end)
+		{
+			const char *eol = find_newline(p, end);
+			if (!list_stream_append(stream, p, (size_t)((eol ? eol : end) - p)))
+			{
+				return 0;
+			}
+			if (!eol)
+			{
+				break;
+			}
+			if (!list_stream_flush(stream))
+			{
+				return 0;
+			}
+			p = eol + 1;
+		}
+
+		return realsize;
+	}
+
+	int ftp_client_list_dir_stream(ftp_client_t *client, const char *remote_path, ftp_entry_callback_t on_entry,
+								   void *user_data)
+	{
+		if (!client || !client->curl || !remote_path || !on_entry)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		probe_server_features(client);
+
+		ftp_list_stream_t stream;
+		memset(&stream, 0, sizeof(stream));
+		stream.callback = on_entry;
+		stream.user_data = user_data;
+		stream.is_mlsd = (client->server_features & FTP_FEATURE_MLSD) != 0;
+		stream.now = (int64_t)time(NULL);
+
+		int result = perform_listing(client, remote_path, stream.is_mlsd, list_stream_write_callback, &stream);
+
+		/* The last line may lack a line terminator */
+		if (result == FTP_OK && stream.length > 0 && !list_stream_flush(&stream))
+		{
+			result = FTP_ERROR_TRANSFER;
+		}
+
+		free(stream.line);
+
+		if (stream.out_of_memory)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for listing line");
+			return FTP_ERROR_MEMORY;
+		}
+		if (stream.aborted && result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Directory listing stopped by callback");
+		}
+		return result;
+	}
+
+	int ftp_entry_list_parse(const char *listing, size_t size, ftp_entry_list_t *list)
+	{
+		if (!listing || !list)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		list->entries = NULL;
+		list->count = 0;
+		list->arena = NULL;
+
+		/* Names are terminated in place, so parse a private copy */
+		char *data = (char *)malloc(size + 1);
+		if (!data)
+		{
+			return FTP_ERROR_MEMORY;
+		}
+		memcpy(data, listing, size);
+		data[size] = '\0';
+
+		return build_entry_list(data, size, 0, list);
+	}
+
+	void ftp_entry_list_free(ftp_entry_list_t *list)
+	{
+		if (list)
+		{
+			free(list->entries);
+			free(list->arena);
+			list->entries = NULL;
+			list->count = 0;
+			list->arena = NULL;
+		}
+	}
+
+	int ftp_client_mkdir(ftp_client_t *client, const char *remote_path)
+	{
+		if (!client || !client->curl || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		size_t path_len = strlen(remote_path);
+		size_t cmd_len = 4 + path_len + 1;
+		if (cmd_len > 512)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Path too long for MKD command");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		struct curl_slist *commands = NULL;
+		char cmd[512];
+		snprintf(cmd, sizeof(cmd), "MKD %s", remote_path);
+		commands = curl_slist_append(commands, cmd);
+
+		int result = ftp_client_execute_simple_command(client, commands, "Create directory failed");
+		cache_invalidate(client, remote_path, 0);
+
+		curl_slist_free_all(commands);
+		return result;
+	}
+
+	int ftp_client_rmdir(ftp_client_t *client, const char *remote_path)
+	{
+		if (!client || !client->curl || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		size_t path_len = strlen(remote_path);
+		size_t cmd_len = 4 + path_len + 1;
+		if (cmd_len > 512)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Path too long for RMD command");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		struct curl_slist *commands = NULL;
+		char cmd[512];
+		snprintf(cmd, sizeof(cmd), "RMD %s", remote_path);
+		commands = curl_slist_append(commands, cmd);
+
+		int result = ftp_client_execute_simple_command(client, commands, "Remove directory failed");
+		cache_invalidate(client, remote_path, 1);
+
+		curl_slist_free_all(commands);
+		return result;
+	}
+
+	int ftp_client_delete(ftp_client_t *client, const char *remote_path)
+	{
+		if (!client || !client->curl || !remote_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		size_t path_len = strlen(remote_path);
+		size_t cmd_len = 5 + path_len + 1;
+		if (cmd_len > 512)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Path too long for DELE command");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		struct curl_slist *commands = NULL;
+		char cmd[512];
+		snprintf(cmd, sizeof(cmd), "DELE %s", remote_path);
+		commands = curl_slist_append(commands, cmd);
+
+		int result = ftp_client_execute_simple_command(client, commands, "Delete file failed");
+		cache_invalidate(client, remote_path, 0);
+
+		curl_slist_free_all(commands);
+		return result;
+	}
+
+	int ftp_client_rename(ftp_client_t *client, const char *old_path, const char *new_path)
+	{
+		if (!client || !client->curl || !old_path || !new_path)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		size_t old_len = strlen(old_path);
+		size_t new_len = strlen(new_path);
+
+		size_t cmd1_len = 5 + old_len + 1;
+		size_t cmd2_len = 5 + new_len + 1;
+
+		if (cmd1_len > 512 || cmd2_len > 512)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Path too long for RNFR/RNTO command");
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		struct curl_slist *commands = NULL;
+		char cmd1[512], cmd2[512];
+		snprintf(cmd1, sizeof(cmd1), "RNFR %s", old_path);
+		snprintf(cmd2, sizeof(cmd2), "RNTO %s", new_path);
+		commands = curl_slist_append(commands, cmd1);
+		commands = curl_slist_append(commands, cmd2);
+
+		int result = ftp_client_execute_simple_command(client, commands, "Rename failed");
+		cache_invalidate(client, old_path, 1);
+		cache_invalidate(client, new_path, 1);
+
+		curl_slist_free_all(commands);
+		return result;
+	}
+
+	int ftp_client_get_filesize(ftp_client_t *client, const char *remote_path, int64_t *size)
+	{
+		if (!client || !client->curl || !remote_path || !size)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		if (cache_lookup_info(client, remote_path, size, NULL))
+		{
+			return FTP_OK;
+		}
+
+		int64_t filesize, filetime;
+		int result = query_file_info(client, remote_path, &filesize, &filetime);
+		if (result != FTP_OK)
+		{
+			return result;
+		}
+		if (filesize < 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Could not retrieve file size");
+			return FTP_ERROR_TRANSFER;
+		}
+
+		*size = filesize;
+		return FTP_OK;
+	}
+
+	int ftp_client_get_mtime(ftp_client_t *client, const char *remote_path, int64_t *mtime)
+	{
+		if (!client || !client->curl || !remote_path || !mtime)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		if (cache_lookup_info(client, remote_path, NULL, mtime))
+		{
+			return FTP_OK;
+		}
+
+		int64_t filesize, filetime;
+		int result = query_file_info(client, remote_path, &filesize, &filetime);
+		if (result != FTP_OK)
+		{
+			return result;
+		}
+		if (filetime < 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Could not retrieve modification time");
+			return FTP_ERROR_TRANSFER;
+		}
+
+		*mtime = filetime;
+		return FTP_OK;
+	}
+
+	int ftp_client_execute_command(ftp_client_t *client, const char *command, char **response)
+	{
+		if (!client || !client->curl || !command)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		/* Reset curl handle to default state */
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, "/", url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "URL too long");
+			return result;
+		}
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+
+		struct curl_slist *commands = NULL;
+		commands = curl_slist_append(commands, command);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, commands);
+
+		ftp_memory_buffer_t buffer = {0};
+		set_reply_callback(client, write_memory_callback, &buffer);
+
+		CURLcode res = perform_curl(client);
+
+		curl_slist_free_all(commands);
+
+		if (res != CURLE_OK)
+		{
+			if (buffer.data)
+			{
+				free(buffer.data);
+			}
+			snprintf(client->last_error, sizeof(client->last_error), "Command execution failed: %s",
+					 curl_easy_strerror(res));
+			return FTP_ERROR_TRANSFER;
+		}
+
+		if (response)
+		{
+			*response = buffer.data;
+		}
+		else if (buffer.data)
+		{
+			free(buffer.data);
+		}
+
+		return FTP_OK;
+	}
+
+	/* Sent ahead of the batch; libcurl's own commands on connect (PWD, ...) could match batch commands */
+#define FTP_BATCH_MARKER "NOOP"
+
+	/* Reply capture state for batched commands */
+	typedef struct
+	{
+		ftp_client_t *client;
+		const char *const *commands;
+		size_t count;
+		ftp_command_result_t *results;
+		int started;	/* The marker NOOP has gone out; earlier lines are libcurl's own */
+		size_t next;	/* Next command expected on the wire */
+		long current;	/* Command whose reply is being read, or -1 */
+		size_t text_len;
+	} ftp_batch_state_t;
+
+	/* Compare a sent line (without CRLF) with a batch command */
+	static int batch_command_matches(const char *sent, size_t sent_len, const char *command)
+	{
+		while (sent_len > 0 && (sent[sent_len - 1] == '\r' || sent[sent_len - 1] == '\n'))
+		{
+			sent_len--;
+		}
+		return strlen(command) == sent_len && memcmp(sent, command, sent_len) == 0;
+	}
+
+	static void batch_record_reply_line(ftp_batch_state_t *state, const char *line, size_t len)
+	{
+		ftp_command_result_t *result = &state->results[state->current];
+		size_t room = sizeof(result->text) - 1 - state->text_len;
+		size_t copy = len;
+
+		if (state->text_len > 0 && room > 0)
+		{
+			result->text[state->text_len++] = '\n';
+			room--;
+		}
+		if (copy > room)
+		{
+			copy = room;
+		}
+		memcpy(result->text + state->text_len, line, copy);
+		state->text_len += copy;
+		result->text[state->text_len] = '\0';
+
+		/* "ddd " marks the last line of a reply; "ddd-" continues it */
+		if (len >= 4 && line[3] == ' ' && isdigit((unsigned char)line[0]) && isdigit((unsigned char)line[1]) &&
+			isdigit((unsigned char)line[2]))
+		{
+			result->code = (line[0] - '0') * 100 + (line[1] - '0') * 10 + (line[2] - '0');
+			state->current = -1;
+		}
+	}
+
+	static int batch_debug_callback(CURL *handle, curl_infotype type, char *data, size_t size, void *userp)
+	{
+		ftp_batch_state_t *state = (ftp_batch_state_t *)userp;
+		(void)handle;
+
+		echo_verbose_output(state->client, type, data, size);
+
+		if (type == CURLINFO_HEADER_OUT && !state->started)
+		{
+			state->started = batch_command_matches(data, size, FTP_BATCH_MARKER);
+		}
+		else if (type == CURLINFO_HEADER_OUT && state->next < state->count)
+		{
+			if (batch_command_matches(data, size, state->commands[state->next]))
+			{
+				state->current = (long)state->next++;
+				state->text_len = 0;
+			}
+		}
+		else if (type == CURLINFO_HEADER_IN && state->current >= 0)
+		{
+			while (size > 0 && state->current >= 0)
+			{
+				const char *eol = (const char *)memchr(data, '\n', size);
+				size_t line_len = eol ? (size_t)(eol - data) + 1 : size;
+				size_t text_len = line_len;
+				while (text_len > 0 && (data[text_len - 1] == '\r' || data[text_len - 1] == '\n'))
+				{
+					text_len--;
+				}
+				batch_record_reply_line(state, data, text_len);
+				data += line_len;
+				size -= line_len;
+			}
+		}
+
+		return 0;
+	}
+
+	int ftp_client_execute_batch(ftp_client_t *client, const char *const *commands, size_t count,
+								 ftp_command_result_t *results, ftp_batch_policy_t policy)
+	{
+		if (!client || !client->curl || !commands || count == 0)
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
+
+		reset_transfer_stats(client);
+
+		size_t i;
+		for (i = 0; i < count; i++)
+		{
+			if (!commands[i])
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Batch command %lu is NULL", (unsigned long)i);
+				return FTP_ERROR_INVALID_PARAM;
+			}
+		}
+
+		ftp_command_result_t *replies = results;
+		if (!replies)
+		{
+			replies = (ftp_command_result_t *)malloc(count * sizeof(*replies));
+			if (!replies)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for replies");
+				return FTP_ERROR_MEMORY;
+			}
+		}
+		memset(replies, 0, count * sizeof(*replies));
+
+		/* libcurl ignores failures of quote commands prefixed with '*' */
+		struct curl_slist *list = NULL;
+		struct curl_slist *next = curl_slist_append(NULL, FTP_BATCH_MARKER);
+		for (i = 0; next && i < count; i++)
+		{
+			list = next;
+			if (policy == FTP_BATCH_CONTINUE_ON_ERROR)
+			{
+				size_t len = strlen(commands[i]);
+				char *line = (char *)malloc(len + 2);
+				next = NULL;
+				if (line)
+				{
+					line[0] = '*';
+					memcpy(line + 1, commands[i], len + 1);
+					next = curl_slist_append(list, line);
+					free(line);
+				}
+			}
+			else
+			{
+				next = curl_slist_append(list, commands[i]);
+			}
+		}
+		if (!next)
+		{
+			curl_slist_free_all(list);
+			if (replies != results)
+			{
+				free(replies);
+			}
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for commands");
+			return FTP_ERROR_MEMORY;
+		}
+		list = next;
+
+		prepare_curl_handle(client);
+
+		char url[FTP_MAX_URL_LENGTH];
+		int result = build_ftp_url(client, "/", url, sizeof(url));
+		if (result != FTP_OK)
+		{
+			curl_slist_free_all(list);
+			if (replies != results)
+			{
+				free(replies);
+			}
+			snprintf(client->last_error, sizeof(client->last_error), "URL too long");
+			return result;
+		}
+
+		ftp_batch_state_t state;
+		state.client = client;
+		state.commands = commands;
+		state.count = count;
+		state.results = replies;
+		state.started = 0;
+		state.next = 0;
+		state.current = -1;
+		state.text_len = 0;
+
+		curl_easy_setopt(client->curl, CURLOPT_URL, url);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, list);
+		curl_easy_setopt(client->curl, CURLOPT_NOBODY, 1L);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGFUNCTION, batch_debug_callback);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGDATA, &state);
+		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, 1L);
+
+		CURLcode res = perform_curl(client);
+
+		/* Do not leave a pointer to the stack state behind in session mode */
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGFUNCTION, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_DEBUGDATA, NULL);
+		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, client->config.verbose ? 1L : 0L);
+		curl_easy_setopt(client->curl, CURLOPT_QUOTE, NULL);
+		curl_slist_free_all(list);
+
+		long failed = -1;
+		for (i = 0; i < count; i++)
+		{
+			if (replies[i].code == 0 || replies[i].code >= 400)
+			{
+				failed = (long)i;
+				break;
+			}
+		}
+
+		if (res != CURLE_OK && res != CURLE_QUOTE_ERROR)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Batch execution failed: %s",
+					 curl_easy_strerror(res));
+			result = FTP_ERROR_TRANSFER;
+		}
+		else if (failed >= 0)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Batch command %ld failed: %s", failed,
+					 replies[failed].code ? replies[failed].text : "not sent");
+			result = FTP_ERROR_TRANSFER;
+		}
+
+		if (replies != results)
+		{
+			free(replies);
+		}
+		return result;
+	}
+
+	const char *ftp_client_get_error(ftp_client_t *client)
+	{
+		if (!client)
+		{
+			return "Invalid client handle";
+		}
+		return client->last_error;
+	}
+
+	void ftp_client_destroy(ftp_client_t *client)
+	{
+		if (client)
+		{
+			if (client->curl)
+			{
+				curl_easy_cleanup(client->curl);
+			}
+
+			free(client->checksum_state);
+			if (client->throttle_state)
+			{
+				ftp_rate_limiter_destroy(client->throttle_state->own);
+				free(client->throttle_state);
+			}
+#ifdef FTP_CLIENT_ENABLE_ZLIB
+			compression_state_destroy(client->compression_state);
+#endif
+
+			if (client->config.host)
+			{
+				size_t host_len = strlen(client->config.host);
+				if (host_len > 0)
+				{
+					volatile char *p = (volatile char *)memset(client->config.host, 0, host_len);
+					(void)p;
+				}
+				free(client->config.host);
+			}
+
+			if (client->config.username)
+			{
+				size_t username_len = strlen(client->config.username);
+				volatile char *p = (volatile char *)memset(client->config.username, 0, username_len);
+				(void)p;
+				free(client->config.username);
+			}
 
-	/**
-	 * @brief Destroy FTP client handle and free resources
-	 *
-	 * Cleans up and deallocates an FTP client handle.
-	 *
-	 * @param client Pointer to the FTP client handle to destroy
-	 *
-	 * @note After calling this function, the client pointer is invalid and should not be used.
-	 *       It is safe to pass NULL to this function (it will do nothing).
-	 *       This does not call ftp_global_cleanup() - that must be called separately.
-	 *
-	 * Example:
-	 * @code
-	 * ftp_client_destroy(client);
-	 * client = NULL;  // Good practice to avoid dangling pointer
-	 * @endcode
-	 */
-	void ftp_client_destroy(ftp_client_t *client);
+			if (client->config.password)
+			{
+				size_t password_len = strlen(client->config.password);
+				volatile char *p = (volatile char *)memset(client->config.password, 0, password_len);
+				(void)p;
+				free(client->config.password);
+			}
 
-#ifdef FTP_CLIENT_IMPLEMENTATION
+			free(client);
+		}
+	}
 
-	/* Internal helper functions */
+	ftp_client_t *ftp_client_duplicate(const ftp_client_t *client)
+	{
+		if (!client)
+		{
+			return NULL;
+		}
 
-	static size_t write_memory_callback(void *contents, size_t size, size_t nmemb, void *userp)
+		ftp_client_t *copy = ftp_client_create();
+		if (!copy)
+		{
+			return NULL;
+		}
+
+		if ((client->config.host && ftp_client_set_host(copy, client->config.host, client->config.port) != FTP_OK) ||
+			ftp_client_set_credentials(copy, client->config.username, client->config.password) != FTP_OK)
+		{
+			ftp_client_destroy(copy);
+			return NULL;
+		}
+
+		copy->config.port = client->config.port;
+		copy->server_features = client->server_features;
+		copy->cache = client->cache;
+		copy->rate_limiter = client->rate_limiter;
+		copy->config.mode = client->config.mode;
+		copy->config.ssl_mode = client->config.ssl_mode;
+		copy->config.verify_ssl = client->config.verify_ssl;
+		copy->config.timeout = client->config.timeout;
+		copy->config.connect_timeout = client->config.connect_timeout;
+		copy->config.verbose = client->config.verbose;
+		copy->config.keep_session = client->config.keep_session;
+		copy->config.resume_downloads = client->config.resume_downloads;
+		copy->config.mmap_uploads = client->config.mmap_uploads;
+		copy->config.preallocate_downloads = client->config.preallocate_downloads;
+		copy->config.atomic_downloads = client->config.atomic_downloads;
+		copy->config.fsync_policy = client->config.fsync_policy;
+		copy->config.receive_buffer_size = client->config.receive_buffer_size;
+		copy->config.upload_buffer_size = client->config.upload_buffer_size;
+		copy->config.file_buffer_size = client->config.file_buffer_size;
+		copy->config.checksum_types = client->config.checksum_types;
+		copy->config.compression_level = client->config.compression_level;
+		copy->config.progress_callback = client->config.progress_callback;
+		copy->config.progress_user_data = client->config.progress_user_data;
+
+		if (ftp_client_set_max_speed(copy, client->config.max_send_speed, client->config.max_receive_speed) != FTP_OK)
+		{
+			ftp_client_destroy(copy);
+			return NULL;
+		}
+		return copy;
+	}
+
+	/* Connection pool */
+
+#define FTP_POOL_EVICT_BATCH 64
+
+	struct ftp_pool
 	{
-		size_t realsize = size * nmemb;
-		ftp_memory_buffer_t *mem = (ftp_memory_buffer_t *)userp;
+		ftp_client_t *prototype;
+		ftp_pool_options_t options;
+		ftp_mutex_t mutex;
+		ftp_cond_t available;
+
+		/* LIFO stack of idle sessions; the bottom holds the longest idle ones */
+		ftp_client_t **idle;
+		int64_t *idle_since;
+		size_t idle_count;
+
+		size_t total; /* Sessions alive or being created, including checked-out ones */
+		ftp_pool_stats_t stats;
+		char last_error[512];
+	};
 
-		if (mem->size + realsize + 1 > mem->capacity)
+	void ftp_pool_init_options(ftp_pool_options_t *options)
+	{
+		if (options)
 		{
-			size_t new_capacity = mem->capacity == 0 ? FTP_BUFFER_SIZE : mem->capacity * 2;
-			while (new_capacity < mem->size + realsize + 1)
+			options->min_sessions = 1;
+			options->max_sessions = 8;
+			options->idle_timeout = 60;
+			options->checkout_timeout = 30;
+		}
+	}
+
+	static ftp_client_t *pool_open_session(ftp_pool_t *pool, char *error, size_t error_size)
+	{
+		ftp_client_t *client = ftp_client_duplicate(pool->prototype);
+		if (!client)
+		{
+			snprintf(error, error_size, "Failed to allocate pool session");
+			return NULL;
+		}
+
+		client->config.keep_session = 1;
+		if (ftp_client_connect(client) != FTP_OK)
+		{
+			snprintf(error, error_size, "%s", client->last_error);
+			ftp_client_destroy(client);
+			return NULL;
+		}
+		return client;
+	}
+
+	/* Move idle sessions past their timeout into victims; caller holds the mutex */
+	static size_t pool_collect_expired(ftp_pool_t *pool, ftp_client_t **victims, size_t max_victims)
+	{
+		if (pool->options.idle_timeout <= 0)
+		{
+			return 0;
+		}
+
+		int64_t cutoff = ftp_time_ms() - (int64_t)pool->options.idle_timeout * 1000;
+		size_t count = 0;
+		while (count < max_victims && count < pool->idle_count && pool->total > pool->options.min_sessions &&
+			   pool->idle_since[count] <= cutoff)
+		{
+			victims[count] = pool->idle[count];
+			pool->total--;
+			count++;
+		}
+
+		if (count > 0)
+		{
+			pool->idle_count -= count;
+			memmove(pool->idle, pool->idle + count, pool->idle_count * sizeof(ftp_client_t *));
+			memmove(pool->idle_since, pool->idle_since + count, pool->idle_count * sizeof(int64_t));
+			pool->stats.evicted += (unsigned long)count;
+		}
+		return count;
+	}
+
+	static void pool_destroy_sessions(ftp_client_t **victims, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			ftp_client_destroy(victims[i]);
+		}
+	}
+
+	ftp_pool_t *ftp_pool_create(ftp_client_t *prototype, const ftp_pool_options_t *options)
+	{
+		if (!prototype)
+		{
+			return NULL;
+		}
+
+		ftp_pool_t *pool = (ftp_pool_t *)calloc(1, sizeof(ftp_pool_t));
+		if (!pool)
+		{
+			snprintf(prototype->last_error, sizeof(prototype->last_error), "Failed to allocate connection pool");
+			return NULL;
+		}
+
+		if (options)
+		{
+			pool->options = *options;
+		}
+		else
+		{
+			ftp_pool_init_options(&pool->options);
+		}
+
+		if (pool->options.max_sessions == 0 || pool->options.min_sessions > pool->options.max_sessions)
+		{
+			snprintf(prototype->last_error, sizeof(prototype->last_error),
+					 "Pool requires 0 <= min_sessions <= max_sessions and max_sessions > 0");
+			free(pool);
+			return NULL;
+		}
+
+		pool->prototype = ftp_client_duplicate(prototype);
+		pool->idle = (ftp_client_t **)calloc(pool->options.max_sessions, sizeof(ftp_client_t *));
+		pool->idle_since = (int64_t *)calloc(pool->options.max_sessions, sizeof(int64_t));
+		if (!pool->prototype || !pool->idle || !pool->idle_since)
+		{
+			snprintf(prototype->last_error, sizeof(prototype->last_error), "Failed to allocate connection pool");
+			ftp_client_destroy(pool->prototype);
+			free(pool->idle);
+			free(pool->idle_since);
+			free(pool);
+			return NULL;
+		}
+
+		ftp_mutex_init(&pool->mutex);
+		ftp_cond_init(&pool->available);
+
+		/* Log in the minimum number of sessions up front */
+		while (pool->total < pool->options.min_sessions)
+		{
+			ftp_client_t *client = pool_open_session(pool, prototype->last_error, sizeof(prototype->last_error));
+			if (!client)
 			{
-				new_capacity *= 2;
+				ftp_pool_destroy(pool);
+				return NULL;
 			}
+			pool->idle[pool->idle_count] = client;
+			pool->idle_since[pool->idle_count] = ftp_time_ms();
+			pool->idle_count++;
+			pool->total++;
+			pool->stats.created++;
+		}
 
-			char *new_data = (char *)realloc(mem->data, new_capacity);
-			if (!new_data)
+		return pool;
+	}
+
+	ftp_client_t *ftp_pool_checkout(ftp_pool_t *pool)
+	{
+		if (!pool)
+		{
+			return NULL;
+		}
+
+		ftp_client_t *victims[FTP_POOL_EVICT_BATCH];
+		size_t victim_count = 0;
+		ftp_client_t *client = NULL;
+		int64_t deadline = ftp_time_ms() + (int64_t)pool->options.checkout_timeout * 1000;
+
+		ftp_mutex_lock(&pool->mutex);
+		pool->stats.checkouts++;
+
+		for (;;)
+		{
+			if (victim_count == 0 && pool->idle_count > 0)
 			{
-				return 0;
+				victim_count = pool_collect_expired(pool, victims, sizeof(victims) / sizeof(victims[0]));
 			}
-			mem->data = new_data;
-			mem->capacity = new_capacity;
-		}
 
-		memcpy(&(mem->data[mem->size]), contents, realsize);
-		mem->size += realsize;
-		mem->data[mem->size] = 0;
+			if (pool->idle_count > 0)
+			{
+				pool->idle_count--;
+				client = pool->idle[pool->idle_count];
+				pool->stats.in_use++;
+				break;
+			}
 
-		return realsize;
+			if (pool->total < pool->options.max_sessions)
+			{
+				/* Reserve the slot, then log in without holding the lock */
+				pool->total++;
+				ftp_mutex_unlock(&pool->mutex);
+
+				char error[512];
+				client = pool_open_session(pool, error, sizeof(error));
+
+				ftp_mutex_lock(&pool->mutex);
+				if (client)
+				{
+					pool->stats.created++;
+					pool->stats.in_use++;
+				}
+				else
+				{
+					pool->total--;
+					snprintf(pool->last_error, sizeof(pool->last_error), "%s", error);
+					ftp_cond_signal(&pool->available);
+				}
+				break;
+			}
+
+			pool->stats.waits++;
+			if (pool->options.checkout_timeout <= 0)
+			{
+				ftp_cond_wait(&pool->available, &pool->mutex);
+				continue;
+			}
+
+			int64_t remaining = deadline - ftp_time_ms();
+			if (remaining <= 0 || (ftp_cond_timedwait(&pool->available, &pool->mutex, (long)remaining) &&
+								   pool->idle_count == 0 && pool->total >= pool->options.max_sessions))
+			{
+				snprintf(pool->last_error, sizeof(pool->last_error), "Timed out waiting for a pool session");
+				break;
+			}
+		}
+
+		ftp_mutex_unlock(&pool->mutex);
+		pool_destroy_sessions(victims, victim_count);
+		return client;
 	}
 
-	static size_t read_file_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	void ftp_pool_checkin(ftp_pool_t *pool, ftp_client_t *client)
 	{
-		size_t retcode = fread(ptr, size, nmemb, (FILE *)stream);
-		return retcode;
+		if (!pool || !client)
+		{
+			return;
+		}
+
+		ftp_client_t *victims[FTP_POOL_EVICT_BATCH];
+
+		ftp_mutex_lock(&pool->mutex);
+		size_t victim_count = pool_collect_expired(pool, victims, sizeof(victims) / sizeof(victims[0]));
+		pool->idle[pool->idle_count] = client;
+		pool->idle_since[pool->idle_count] = ftp_time_ms();
+		pool->idle_count++;
+		pool->stats.in_use--;
+		ftp_cond_signal(&pool->available);
+		ftp_mutex_unlock(&pool->mutex);
+
+		pool_destroy_sessions(victims, victim_count);
 	}
 
-	static size_t write_file_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	void ftp_pool_discard(ftp_pool_t *pool, ftp_client_t *client)
 	{
-		size_t written = fwrite(ptr, size, nmemb, (FILE *)stream);
-		return written;
+		if (!pool || !client)
+		{
+			return;
+		}
+
+		ftp_mutex_lock(&pool->mutex);
+		pool->total--;
+		pool->stats.in_use--;
+		ftp_cond_signal(&pool->available);
+		ftp_mutex_unlock(&pool->mutex);
+
+		ftp_client_destroy(client);
 	}
 
-	static int progress_callback_wrapper(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal,
-										 curl_off_t ulnow)
+	size_t ftp_pool_evict_idle(ftp_pool_t *pool)
 	{
-		ftp_client_t *client = (ftp_client_t *)clientp;
-		if (client->config.progress_callback)
+		if (!pool)
 		{
-			return client->config.progress_callback(client->config.progress_user_data, (double)dltotal, (double)dlnow,
-													(double)ultotal, (double)ulnow);
+			return 0;
 		}
-		return 0;
+
+		ftp_client_t *victims[FTP_POOL_EVICT_BATCH];
+		size_t evicted = 0;
+		size_t count;
+
+		do
+		{
+			ftp_mutex_lock(&pool->mutex);
+			count = pool_collect_expired(pool, victims, sizeof(victims) / sizeof(victims[0]));
+			ftp_mutex_unlock(&pool->mutex);
+
+			pool_destroy_sessions(victims, count);
+			evicted += count;
+		} while (count > 0);
+
+		return evicted;
 	}
 
-	static int build_ftp_url(const ftp_client_t *client, const char *remote_path, char *url, size_t url_size)
+	int ftp_pool_get_stats(ftp_pool_t *pool, ftp_pool_stats_t *stats)
 	{
-		const char *protocol = "ftp";
-
-		if (!client->config.host)
+		if (!pool || !stats)
 		{
 			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		size_t host_len = strlen(client->config.host);
-		if (host_len == 0 || host_len > 255)
+		ftp_mutex_lock(&pool->mutex);
+		*stats = pool->stats;
+		stats->total = pool->total;
+		stats->idle = pool->idle_count;
+		ftp_mutex_unlock(&pool->mutex);
+		return FTP_OK;
+	}
+
+	const char *ftp_pool_get_error(ftp_pool_t *pool)
+	{
+		if (!pool)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			return "Invalid pool handle";
 		}
+		return pool->last_error;
+	}
 
-		for (size_t i = 0; i < host_len; i++)
+	void ftp_pool_destroy(ftp_pool_t *pool)
+	{
+		if (pool)
 		{
-			char c = client->config.host[i];
-			if (c == '\0' || c == '/' || c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			pool_destroy_sessions(pool->idle, pool->idle_count);
+			ftp_client_destroy(pool->prototype);
+			ftp_cond_destroy(&pool->available);
+			ftp_mutex_destroy(&pool->mutex);
+			free(pool->idle);
+			free(pool->idle_since);
+			free(pool);
+		}
+	}
+
+	/* Multi-file transfer queue */
+
+	typedef struct
+	{
+		ftp_job_type_t type;
+		char *local_path;
+		char *remote_path;
+		ftp_job_state_t state;
+		int result;
+		int64_t bytes;
+		double seconds;
+		char *error;
+	} ftp_queue_job_t;
+
+	struct ftp_transfer_queue
+	{
+		ftp_client_t *prototype;
+		ftp_mutex_t mutex;
+		ftp_cond_t work_available;
+		ftp_cond_t all_done;
+
+		ftp_queue_job_t *jobs;
+		size_t job_count;
+		size_t job_capacity;
+		size_t next_job; /* Jobs run in submission order */
+
+		ftp_thread_t *threads;
+		int worker_count;
+		int shutdown;
+
+		size_t running;
+		size_t completed;
+		size_t failed;
+		int64_t bytes;
+		int64_t started_ms;
+		int64_t finished_ms;
+	};
+
+	static FTP_THREAD_PROC(transfer_queue_worker)
+	{
+		ftp_transfer_queue_t *queue = (ftp_transfer_queue_t *)arg;
+		ftp_client_t *client = ftp_client_duplicate(queue->prototype);
+
+		ftp_mutex_lock(&queue->mutex);
+		for (;;)
+		{
+			while (!queue->shutdown && queue->next_job >= queue->job_count)
 			{
-				return FTP_ERROR_INVALID_PARAM;
+				ftp_cond_wait(&queue->work_available, &queue->mutex);
+			}
+			if (queue->shutdown)
+			{
+				break;
+			}
+
+			size_t index = queue->next_job++;
+			ftp_queue_job_t job = queue->jobs[index];
+			queue->jobs[index].state = FTP_JOB_RUNNING;
+			queue->running++;
+			ftp_mutex_unlock(&queue->mutex);
+
+			/* Run the transfer without holding the lock; the path strings never move */
+			int64_t start_ms = ftp_time_ms();
+			int result = FTP_ERROR_MEMORY;
+			curl_off_t bytes = 0;
+			if (client)
+			{
+				if (job.type == FTP_JOB_UPLOAD)
+				{
+					result = ftp_client_upload(client, job.local_path, job.remote_path);
+					curl_easy_getinfo(client->curl, CURLINFO_SIZE_UPLOAD_T, &bytes);
+				}
+				else
+				{
+					result = ftp_client_download(client, job.remote_path, job.local_path);
+					curl_easy_getinfo(client->curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+				}
+			}
+			int64_t end_ms = ftp_time_ms();
+
+			ftp_mutex_lock(&queue->mutex);
+			ftp_queue_job_t *done = &queue->jobs[index];
+			done->result = result;
+			done->seconds = (double)(end_ms - start_ms) / 1000.0;
+			done->bytes = result == FTP_OK ? (int64_t)bytes : 0;
+			if (result == FTP_OK)
+			{
+				done->state = FTP_JOB_DONE;
+				queue->completed++;
+				queue->bytes += done->bytes;
+			}
+			else
+			{
+				done->state = FTP_JOB_FAILED;
+				done->error = strdup(client ? client->last_error : "Failed to allocate worker client");
+				queue->failed++;
+			}
+			queue->running--;
+			queue->finished_ms = end_ms;
+
+			if (queue->completed + queue->failed == queue->job_count)
+			{
+				ftp_cond_broadcast(&queue->all_done);
 			}
 		}
+		ftp_mutex_unlock(&queue->mutex);
 
-		size_t base_len = strlen(protocol) + 3 + host_len + 6; /* 6 chars max for port (65535) */
-		size_t path_len = remote_path ? strlen(remote_path) : 0;
-		size_t required_len = base_len + path_len + 1;
+		ftp_client_destroy(client);
+		FTP_THREAD_RETURN;
+	}
 
-		if (required_len > url_size)
+	ftp_transfer_queue_t *ftp_transfer_queue_create(const ftp_client_t *prototype, int workers)
+	{
+		if (!prototype || workers <= 0)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			return NULL;
 		}
 
-		int written;
-		if (remote_path && remote_path[0] == '/')
+		ftp_transfer_queue_t *queue = (ftp_transfer_queue_t *)calloc(1, sizeof(ftp_transfer_queue_t));
+		if (!queue)
 		{
-			written = snprintf(url, url_size, "%s://%s:%d%s", protocol, client->config.host, client->config.port, remote_path);
+			return NULL;
 		}
-		else if (remote_path)
+
+		queue->prototype = ftp_client_duplicate(prototype);
+		queue->threads = (ftp_thread_t *)calloc((size_t)workers, sizeof(ftp_thread_t));
+		if (!queue->prototype || !queue->threads)
 		{
-			written = snprintf(url, url_size, "%s://%s:%d/%s", protocol, client->config.host, client->config.port, remote_path);
+			ftp_client_destroy(queue->prototype);
+			free(queue->threads);
+			free(queue);
+			return NULL;
 		}
-		else
+
+		/* Workers keep their control connection logged in between jobs */
+		queue->prototype->config.keep_session = 1;
+
+		ftp_mutex_init(&queue->mutex);
+		ftp_cond_init(&queue->work_available);
+		ftp_cond_init(&queue->all_done);
+
+		for (int i = 0; i < workers; i++)
 		{
-			written = snprintf(url, url_size, "%s://%s:%d/", protocol, client->config.host, client->config.port);
+			if (ftp_thread_create(&queue->threads[i], transfer_queue_worker, queue) != 0)
+			{
+				break;
+			}
+			queue->worker_count++;
 		}
 
-		/* Check if truncation occurred */
-		if (written < 0 || (size_t)written >= url_size)
+		if (queue->worker_count == 0)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			ftp_transfer_queue_destroy(queue);
+			return NULL;
 		}
-
-		return FTP_OK;
+		return queue;
 	}
 
-	static void setup_curl_common(ftp_client_t *client)
+	long ftp_transfer_queue_submit(ftp_transfer_queue_t *queue, ftp_job_type_t type, const char *local_path,
+								   const char *remote_path)
 	{
-		curl_easy_setopt(client->curl, CURLOPT_USERNAME, client->config.username);
-		curl_easy_setopt(client->curl, CURLOPT_PASSWORD, client->config.password);
-		curl_easy_setopt(client->curl, CURLOPT_TIMEOUT, client->config.timeout);
-		curl_easy_setopt(client->curl, CURLOPT_CONNECTTIMEOUT, client->config.connect_timeout);
-		curl_easy_setopt(client->curl, CURLOPT_VERBOSE, client->config.verbose ? 1L : 0L);
+		if (!queue || !local_path || !remote_path || (type != FTP_JOB_UPLOAD && type != FTP_JOB_DOWNLOAD))
+		{
+			return FTP_ERROR_INVALID_PARAM;
+		}
 
-		/* Transfer mode */
-		if (client->config.mode == FTP_MODE_ACTIVE)
+		ftp_queue_job_t job;
+		memset(&job, 0, sizeof(job));
+		job.type = type;
+		job.state = FTP_JOB_PENDING;
+		job.local_path = strdup(local_path);
+		job.remote_path = strdup(remote_path);
+		if (!job.local_path || !job.remote_path)
 		{
-			curl_easy_setopt(client->curl, CURLOPT_FTPPORT, "-");
+			free(job.local_path);
+			free(job.remote_path);
+			return FTP_ERROR_MEMORY;
 		}
-		else
+
+		ftp_mutex_lock(&queue->mutex);
+		if (queue->job_count == queue->job_capacity)
 		{
-			curl_easy_setopt(client->curl, CURLOPT_FTP_USE_EPSV, 1L);
+			size_t capacity = queue->job_capacity ? queue->job_capacity * 2 : 64;
+			ftp_queue_job_t *jobs = (ftp_queue_job_t *)realloc(queue->jobs, capacity * sizeof(ftp_queue_job_t));
+			if (!jobs)
+			{
+				ftp_mutex_unlock(&queue->mutex);
+				free(job.local_path);
+				free(job.remote_path);
+				return FTP_ERROR_MEMORY;
+			}
+			queue->jobs = jobs;
+			queue->job_capacity = capacity;
 		}
 
-		/* SSL/TLS settings */
-		if (client->config.ssl_mode != FTP_SSL_NONE)
+		if (queue->job_count == 0)
 		{
-			curl_easy_setopt(client->curl, CURLOPT_USE_SSL, (long)client->config.ssl_mode);
-			curl_easy_setopt(client->curl, CURLOPT_SSL_VERIFYPEER, client->config.verify_ssl ? 1L : 0L);
-			curl_easy_setopt(client->curl, CURLOPT_SSL_VERIFYHOST, client->config.verify_ssl ? 2L : 0L);
+			queue->started_ms = ftp_time_ms();
 		}
 
-		/* Progress callback */
-		if (client->config.progress_callback)
+		long job_id = (long)queue->job_count;
+		queue->jobs[queue->job_count++] = job;
+		ftp_cond_signal(&queue->work_available);
+		ftp_mutex_unlock(&queue->mutex);
+		return job_id;
+	}
+
+	int ftp_transfer_queue_wait(ftp_transfer_queue_t *queue)
+	{
+		if (!queue)
 		{
-			curl_easy_setopt(client->curl, CURLOPT_XFERINFOFUNCTION, progress_callback_wrapper);
-			curl_easy_setopt(client->curl, CURLOPT_XFERINFODATA, client);
-			curl_easy_setopt(client->curl, CURLOPT_NOPROGRESS, 0L);
+			return FTP_ERROR_INVALID_PARAM;
 		}
-		else
+
+		ftp_mutex_lock(&queue->mutex);
+		while (queue->completed + queue->failed < queue->job_count)
 		{
-			curl_easy_setopt(client->curl, CURLOPT_NOPROGRESS, 1L);
+			ftp_cond_wait(&queue->all_done, &queue->mutex);
 		}
+		int result = queue->failed > 0 ? FTP_ERROR_TRANSFER : FTP_OK;
+		ftp_mutex_unlock(&queue->mutex);
+		return result;
 	}
 
-	static int ftp_client_execute_simple_command(ftp_client_t *client, struct curl_slist *commands,
-												 const char *error_prefix)
+	int ftp_transfer_queue_get_job_status(ftp_transfer_queue_t *queue, long job_id, ftp_job_status_t *status)
 	{
-		if (!client || !client->curl || !commands)
+		if (!queue || !status || job_id < 0)
 		{
 			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		curl_easy_reset(client->curl);
-
-		char url[FTP_MAX_URL_LENGTH];
-		int result = build_ftp_url(client, "/", url, sizeof(url));
-		if (result != FTP_OK)
+		ftp_mutex_lock(&queue->mutex);
+		if ((size_t)job_id >= queue->job_count)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "%s: URL too long", error_prefix);
-			return result;
+			ftp_mutex_unlock(&queue->mutex);
+			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
-		curl_easy_setopt(client->curl, CURLOPT_QUOTE, commands);
-
-		ftp_memory_buffer_t buffer = {0};
-		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, &buffer);
-
-		CURLcode res = curl_easy_perform(client->curl);
+		const ftp_queue_job_t *job = &queue->jobs[job_id];
+		status->state = job->state;
+		status->result = job->result;
+		status->bytes = job->bytes;
+		status->seconds = job->seconds;
+		snprintf(status->error, sizeof(status->error), "%s", job->error ? job->error : "");
+		ftp_mutex_unlock(&queue->mutex);
+		return FTP_OK;
+	}
 
-		if (buffer.data)
+	int ftp_transfer_queue_get_stats(ftp_transfer_queue_t *queue, ftp_queue_stats_t *stats)
+	{
+		if (!queue || !stats)
 		{
-			free(buffer.data);
+			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		if (res != CURLE_OK)
+		ftp_mutex_lock(&queue->mutex);
+		stats->submitted = queue->job_count;
+		stats->pending = queue->job_count - queue->next_job;
+		stats->running = queue->running;
+		stats->completed = queue->completed;
+		stats->failed = queue->failed;
+		stats->bytes = queue->bytes;
+		stats->elapsed = queue->finished_ms > queue->started_ms
+							 ? (double)(queue->finished_ms - queue->started_ms) / 1000.0
+							 : 0.0;
+		stats->bytes_per_second = stats->elapsed > 0.0 ? (double)stats->bytes / stats->elapsed : 0.0;
+		ftp_mutex_unlock(&queue->mutex);
+		return FTP_OK;
+	}
+
+	void ftp_transfer_queue_destroy(ftp_transfer_queue_t *queue)
+	{
+		if (queue)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "%s: %s", error_prefix, curl_easy_strerror(res));
+			ftp_mutex_lock(&queue->mutex);
+			queue->shutdown = 1;
+			ftp_cond_broadcast(&queue->work_available);
+			ftp_mutex_unlock(&queue->mutex);
 
-			if (res == CURLE_LOGIN_DENIED)
+			for (int i = 0; i < queue->worker_count; i++)
 			{
-				return FTP_ERROR_AUTH;
+				ftp_thread_join(queue->threads[i]);
 			}
-			else if (res == CURLE_OPERATION_TIMEDOUT)
+
+			for (size_t i = 0; i < queue->job_count; i++)
 			{
-				return FTP_ERROR_TIMEOUT;
+				free(queue->jobs[i].local_path);
+				free(queue->jobs[i].remote_path);
+				free(queue->jobs[i].error);
 			}
-			return FTP_ERROR_TRANSFER;
-		}
 
-		return FTP_OK;
+			ftp_cond_destroy(&queue->all_done);
+			ftp_cond_destroy(&queue->work_available);
+			ftp_mutex_destroy(&queue->mutex);
+			ftp_client_destroy(queue->prototype);
+			free(queue->threads);
+			free(queue->jobs);
+			free(queue);
+		}
 	}
 
-	int ftp_global_init(void)
+	/* Asynchronous transfers */
+
+	typedef enum
 	{
-		CURLcode res = curl_global_init(CURL_GLOBAL_DEFAULT);
-		return (res == CURLE_OK) ? FTP_OK : FTP_ERROR_INIT;
-	}
+		FTP_ASYNC_UPLOAD,
+		FTP_ASYNC_DOWNLOAD,
+		FTP_ASYNC_LIST
+	} ftp_async_kind_t;
 
-	void ftp_global_cleanup(void)
+	struct ftp_async_request
 	{
-		curl_global_cleanup();
+		ftp_async_kind_t kind;
+		CURL *curl;
+		FILE *fp;
+		char *local_path;
+		ftp_memory_buffer_t buffer;
+		ftp_async_callback_t callback;
+		void *user_data;
+		char error[512];
+		ftp_transfer_stats_t stats;
+		struct ftp_async *async;
+		size_t (*data_callback)(void *, size_t, size_t, void *); /* Behind the bandwidth limit */
+		void *data_callback_data;
+		int throttled;
+		int64_t resume_ms;
+		struct ftp_async_request *prev;
+		struct ftp_async_request *next;
+	};
+
+	struct ftp_async
+	{
+		ftp_client_t *prototype;
+		CURLM *multi;
+		ftp_async_request_t *active; /* Doubly linked list of running requests */
+		size_t active_count;
+		CURL **spare; /* Finished easy handles kept for reuse */
+		size_t spare_count;
+		size_t spare_capacity;
+	};
+
+	static int map_transfer_error(CURLcode res)
+	{
+		switch (res)
+		{
+		case CURLE_OK:
+			return FTP_OK;
+		case CURLE_REMOTE_FILE_NOT_FOUND:
+			return FTP_ERROR_FILE_NOT_FOUND;
+		case CURLE_LOGIN_DENIED:
+			return FTP_ERROR_AUTH;
+		case CURLE_OPERATION_TIMEDOUT:
+			return FTP_ERROR_TIMEOUT;
+		case CURLE_COULDNT_RESOLVE_HOST:
+		case CURLE_COULDNT_CONNECT:
+			return FTP_ERROR_CONNECTION;
+		default:
+			return FTP_ERROR_TRANSFER;
+		}
 	}
 
-	ftp_client_t *ftp_client_create(void)
+	ftp_async_t *ftp_async_create(const ftp_client_t *prototype, size_t max_connections)
 	{
-		ftp_client_t *client = (ftp_client_t *)calloc(1, sizeof(ftp_client_t));
-		if (!client)
+		if (!prototype)
 		{
 			return NULL;
 		}
 
-		client->curl = curl_easy_init();
-		if (!client->curl)
+		ftp_async_t *async = (ftp_async_t *)calloc(1, sizeof(ftp_async_t));
+		if (!async)
 		{
-			free(client);
 			return NULL;
 		}
 
-		if (ftp_client_init_config(&client->config) != FTP_OK)
+		async->prototype = ftp_client_duplicate(prototype);
+		async->multi = curl_multi_init();
+		if (!async->prototype || !async->multi)
 		{
-			curl_easy_cleanup(client->curl);
-			free(client);
+			ftp_async_destroy(async);
 			return NULL;
 		}
-		return client;
+
+		if (max_connections > 0)
+		{
+			curl_multi_setopt(async->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)max_connections);
+		}
+		return async;
 	}
 
-	int ftp_client_init_config(ftp_config_t *config)
+	static ftp_async_request_t *async_request_new(ftp_async_t *async, ftp_async_kind_t kind, const char *remote_path,
+												  ftp_async_callback_t callback, void *user_data)
 	{
-		memset(config, 0, sizeof(ftp_config_t));
-		config->host = NULL;
-		config->port = 21;
-		config->username = strdup("anonymous");
-		config->password = strdup("user@example.com");
+		ftp_async_request_t *request = (ftp_async_request_t *)calloc(1, sizeof(ftp_async_request_t));
+		if (!request)
+		{
+			return NULL;
+		}
 
-		if (!config->username || !config->password)
+		request->kind = kind;
+		request->callback = callback;
+		request->user_data = user_data;
+		request->async = async;
+
+		if (async->spare_count > 0)
 		{
-			free(config->username);
-			free(config->password);
-			return FTP_ERROR_MEMORY;
+			request->curl = async->spare[--async->spare_count];
+			curl_easy_reset(request->curl);
+		}
+		else
+		{
+			request->curl = curl_easy_init();
 		}
 
-		config->mode = FTP_MODE_PASSIVE;
-		config->ssl_mode = FTP_SSL_NONE;
-		config->verify_ssl = 1;
-		config->timeout = 60;
-		config->connect_timeout = 30;
-		config->verbose = 0;
-		return FTP_OK;
+		char url[FTP_MAX_URL_LENGTH];
+		int result = kind == FTP_ASYNC_LIST ? build_ftp_dir_url(async->prototype, remote_path, url, sizeof(url))
+											: build_ftp_url(async->prototype, remote_path, url, sizeof(url));
+		if (!request->curl || result != FTP_OK)
+		{
+			if (request->curl)
+			{
+				curl_easy_cleanup(request->curl);
+			}
+			free(request);
+			return NULL;
+		}
+
+		curl_easy_setopt(request->curl, CURLOPT_URL, url);
+		curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+		setup_curl_common(async->prototype, request->curl);
+		return request;
 	}
 
-	int ftp_client_set_host(ftp_client_t *client, const char *host, int port)
+	/* Over the bandwidth limit a request pauses itself instead of blocking the event loop */
+	static size_t async_throttle_read_callback(void *ptr, size_t size, size_t nmemb, void *stream)
 	{
-		if (!client)
+		ftp_async_request_t *request = (ftp_async_request_t *)stream;
+		int64_t delay = client_rate_take(request->async->prototype, FTP_RATE_SEND, 0);
+		if (delay > 0)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			request->throttled = 1;
+			request->resume_ms = ftp_time_ms() + delay;
+			return CURL_READFUNC_PAUSE;
 		}
-		if (!host)
+
+		size_t count = request->data_callback(ptr, size, nmemb, request->data_callback_data);
+		if (count > 0 && count <= size * nmemb)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Host parameter is NULL");
-			return FTP_ERROR_INVALID_PARAM;
+			client_rate_take(request->async->prototype, FTP_RATE_SEND, count);
 		}
+		return count;
+	}
 
-		size_t host_len = strlen(host);
-		if (host_len == 0 || host_len > 255)
+	static size_t async_throttle_write_callback(void *ptr, size_t size, size_t nmemb, void *stream)
+	{
+		ftp_async_request_t *request = (ftp_async_request_t *)stream;
+		int64_t delay = client_rate_take(request->async->prototype, FTP_RATE_RECEIVE, 0);
+		if (delay > 0)
 		{
-			snprintf(client->last_error, sizeof(client->last_error),
-					 "Host length must be between 1 and 255 characters");
-			return FTP_ERROR_INVALID_PARAM;
+			request->throttled = 1;
+			request->resume_ms = ftp_time_ms() + delay;
+			return CURL_WRITEFUNC_PAUSE;
 		}
 
-		for (size_t i = 0; i < host_len; i++)
+		size_t count = request->data_callback(ptr, size, nmemb, request->data_callback_data);
+		if (count == size * nmemb)
 		{
-			char c = host[i];
-			if (c == '\0' || c == '/' || c == ' ' || c == '\t' || c == '\n' || c == '\r')
+			client_rate_take(request->async->prototype, FTP_RATE_RECEIVE, count);
+		}
+		return count;
+	}
+
+	static void async_set_callback(ftp_async_request_t *request, int upload,
+								   size_t (*callback)(void *, size_t, size_t, void *), void *data)
+	{
+		if (client_rate_limited(request->async->prototype))
+		{
+			request->data_callback = callback;
+			request->data_callback_data = data;
+			callback = upload ? async_throttle_read_callback : async_throttle_write_callback;
+			data = request;
+		}
+
+		curl_easy_setopt(request->curl, upload ? CURLOPT_READFUNCTION : CURLOPT_WRITEFUNCTION, callback);
+		curl_easy_setopt(request->curl, upload ? CURLOPT_READDATA : CURLOPT_WRITEDATA, data);
+	}
+
+	/* Resume requests whose bandwidth debt is paid; returns milliseconds until the next one is due, or -1 */
+	static int64_t async_resume_throttled(ftp_async_t *async)
+	{
+		int64_t now = ftp_time_ms();
+		int64_t next_due = -1;
+
+		for (ftp_async_request_t *request = async->active; request; request = request->next)
+		{
+			if (request->throttled && request->resume_ms <= now)
 			{
-				snprintf(client->last_error, sizeof(client->last_error), "Host contains invalid characters");
-				return FTP_ERROR_INVALID_PARAM;
+				request->throttled = 0;
+				curl_easy_pause(request->curl, CURLPAUSE_CONT); /* May pause it again right away */
+			}
+			if (request->throttled && (next_due < 0 || request->resume_ms - now < next_due))
+			{
+				next_due = request->resume_ms - now;
 			}
 		}
+		return next_due;
+	}
 
-		char *new_host = strdup(host);
-		if (!new_host)
+	static void async_request_free(ftp_async_t *async, ftp_async_request_t *request)
+	{
+		if (request->fp)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for host");
-			return FTP_ERROR_MEMORY;
+			fclose(request->fp);
 		}
 
-		if (client->config.host)
+		/* Keep the easy handle for the next request to avoid reallocating it */
+		if (async->spare_count == async->spare_capacity)
 		{
-			free(client->config.host);
+			size_t capacity = async->spare_capacity ? async->spare_capacity * 2 : 16;
+			CURL **spare = (CURL **)realloc(async->spare, capacity * sizeof(CURL *));
+			if (spare)
+			{
+				async->spare = spare;
+				async->spare_capacity = capacity;
+			}
+		}
+		if (async->spare_count < async->spare_capacity)
+		{
+			async->spare[async->spare_count++] = request->curl;
+		}
+		else
+		{
+			curl_easy_cleanup(request->curl);
 		}
-		client->config.host = new_host;
 
-		if (port > 0 && port <= 65535)
+		free(request->local_path);
+		free(request->buffer.data);
+		free(request);
+	}
+
+	static ftp_async_request_t *async_request_start(ftp_async_t *async, ftp_async_request_t *request)
+	{
+		if (curl_multi_add_handle(async->multi, request->curl) != CURLM_OK)
 		{
-			client->config.port = port;
+			async_request_free(async, request);
+			return NULL;
 		}
 
-		return FTP_OK;
+		request->next = async->active;
+		if (async->active)
+		{
+			async->active->prev = request;
+		}
+		async->active = request;
+		async->active_count++;
+		return request;
 	}
 
-	int ftp_client_set_credentials(ftp_client_t *client, const char *username, const char *password)
+	static void async_request_finish(ftp_async_t *async, ftp_async_request_t *request, int result)
 	{
-		if (!client)
+		curl_multi_remove_handle(async->multi, request->curl);
+
+		if (request->prev)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			request->prev->next = request->next;
 		}
-		if (!username)
+		else
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Username parameter is NULL");
-			return FTP_ERROR_INVALID_PARAM;
+			async->active = request->next;
 		}
-		if (!password)
+		if (request->next)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Password parameter is NULL");
-			return FTP_ERROR_INVALID_PARAM;
+			request->next->prev = request->prev;
 		}
+		async->active_count--;
 
-		size_t username_len = strlen(username);
-		size_t password_len = strlen(password);
-
-		/* Validate username and password lengths */
-		if (username_len == 0 || username_len > 255)
+		if (request->fp)
 		{
-			snprintf(client->last_error, sizeof(client->last_error),
-					 "Username length must be between 1 and 255 characters");
-			return FTP_ERROR_INVALID_PARAM;
+			fclose(request->fp);
+			request->fp = NULL;
 		}
-		if (password_len == 0 || password_len > 255)
+		if (result != FTP_OK && request->kind == FTP_ASYNC_DOWNLOAD)
 		{
-			snprintf(client->last_error, sizeof(client->last_error),
-					 "Password length must be between 1 and 255 characters");
-			return FTP_ERROR_INVALID_PARAM;
+			remove(request->local_path); /* Delete partial file */
 		}
 
-		char *new_username = strdup(username);
-		if (!new_username)
+		if (request->callback)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for username");
-			return FTP_ERROR_MEMORY;
+			request->callback(request->user_data, request, result);
 		}
+		async_request_free(async, request);
+	}
 
-		char *new_password = strdup(password);
-		if (!new_password)
+	ftp_async_request_t *ftp_async_upload(ftp_async_t *async, const char *local_path, const char *remote_path,
+										  ftp_async_callback_t callback, void *user_data)
+	{
+		if (!async || !local_path || !remote_path)
 		{
-			free(new_username);
-			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for password");
-			return FTP_ERROR_MEMORY;
+			return NULL;
 		}
 
-		/* Free old credentials */
-		if (client->config.username)
+		ftp_async_request_t *request = async_request_new(async, FTP_ASYNC_UPLOAD, remote_path, callback, user_data);
+		if (!request)
 		{
-			free(client->config.username);
+			return NULL;
 		}
-		if (client->config.password)
+
+		int64_t file_size;
+		request->fp = fopen(local_path, "rb");
+		if (!request->fp || get_local_file_size(request->fp, &file_size) != 0)
 		{
-			free(client->config.password);
+			async_request_free(async, request);
+			return NULL;
 		}
 
-		/* Set new credentials */
-		client->config.username = new_username;
-		client->config.password = new_password;
-
-		return FTP_OK;
+		curl_easy_setopt(request->curl, CURLOPT_UPLOAD, 1L);
+		async_set_callback(request, 1, read_file_callback, request->fp);
+		curl_easy_setopt(request->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)file_size);
+		return async_request_start(async, request);
 	}
 
-	void ftp_client_set_mode(ftp_client_t *client, ftp_mode_t mode)
+	ftp_async_request_t *ftp_async_download(ftp_async_t *async, const char *remote_path, const char *local_path,
+											ftp_async_callback_t callback, void *user_data)
 	{
-		if (client)
+		if (!async || !remote_path || !local_path)
 		{
-			client->config.mode = mode;
+			return NULL;
 		}
-	}
 
-	void ftp_client_set_ssl(ftp_client_t *client, ftp_ssl_mode_t ssl_mode, int verify)
-	{
-		if (client)
+		ftp_async_request_t *request = async_request_new(async, FTP_ASYNC_DOWNLOAD, remote_path, callback, user_data);
+		if (!request)
 		{
-			client->config.ssl_mode = ssl_mode;
-			client->config.verify_ssl = verify;
+			return NULL;
 		}
-	}
 
-	void ftp_client_set_timeout(ftp_client_t *client, long timeout, long connect_timeout)
-	{
-		if (client)
+		request->local_path = strdup(local_path);
+		request->fp = request->local_path ? fopen(local_path, "wb") : NULL;
+		if (!request->fp)
 		{
-			if (timeout > 0)
-			{
-				client->config.timeout = timeout;
-			}
-			if (connect_timeout > 0)
-			{
-				client->config.connect_timeout = connect_timeout;
-			}
+			async_request_free(async, request);
+			return NULL;
 		}
+
+		async_set_callback(request, 0, write_file_callback, request->fp);
+		return async_request_start(async, request);
 	}
 
-	void ftp_client_set_verbose(ftp_client_t *client, int verbose)
+	ftp_async_request_t *ftp_async_list(ftp_async_t *async, const char *remote_path, ftp_async_callback_t callback,
+										void *user_data)
 	{
-		if (client)
+		if (!async || !remote_path)
+		{
+			return NULL;
+		}
+
+		ftp_async_request_t *request = async_request_new(async, FTP_ASYNC_LIST, remote_path, callback, user_data);
+		if (!request)
 		{
-			client->config.verbose = verbose;
+			return NULL;
 		}
+
+		async_set_callback(request, 0, write_memory_callback, &request->buffer);
+		return async_request_start(async, request);
 	}
 
-	void ftp_client_set_progress_callback(ftp_client_t *client, ftp_progress_callback_t callback, void *user_data)
+	static void async_process_completed(ftp_async_t *async)
 	{
-		if (client)
+		CURLMsg *msg;
+		int queued;
+
+		while ((msg = curl_multi_info_read(async->multi, &queued)) != NULL)
 		{
-			client->config.progress_callback = callback;
-			client->config.progress_user_data = user_data;
+			if (msg->msg != CURLMSG_DONE)
+			{
+				continue;
+			}
+
+			ftp_async_request_t *request = NULL;
+			CURLcode res = msg->data.result;
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&request);
+			read_transfer_stats(msg->easy_handle, &request->stats);
+
+			if (res != CURLE_OK)
+			{
+				const char *prefix = request->kind == FTP_ASYNC_UPLOAD     ? "Upload failed"
+									 : request->kind == FTP_ASYNC_DOWNLOAD ? "Download failed"
+																			: "Directory listing failed";
+				snprintf(request->error, sizeof(request->error), "%s: %s", prefix, curl_easy_strerror(res));
+			}
+			async_request_finish(async, request, map_transfer_error(res));
 		}
 	}
 
-	int ftp_client_connect(ftp_client_t *client)
+	int ftp_async_poll(ftp_async_t *async, int timeout_ms)
 	{
-		if (!client || !client->curl)
+		if (!async)
 		{
 			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		if (!client->config.host || client->config.host[0] == '\0')
+		int running = 0;
+		int64_t throttled_due = async_resume_throttled(async);
+		if (curl_multi_perform(async->multi, &running) != CURLM_OK)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Host not set");
-			return FTP_ERROR_INVALID_PARAM;
+			return FTP_ERROR_CURL;
 		}
+		async_process_completed(async);
 
-		struct curl_slist *commands = NULL;
-		commands = curl_slist_append(commands, "NOOP");
-
-		int result = ftp_client_execute_simple_command(client, commands, "Connection failed");
-
-		curl_slist_free_all(commands);
+		if (async->active_count > 0 && timeout_ms > 0)
+		{
+			/* Wake up in time to resume throttled requests */
+			if (throttled_due >= 0 && throttled_due < timeout_ms)
+			{
+				timeout_ms = throttled_due > 0 ? (int)throttled_due : 1;
+			}
+			if (curl_multi_wait(async->multi, NULL, 0, timeout_ms, NULL) != CURLM_OK ||
+				curl_multi_perform(async->multi, &running) != CURLM_OK)
+			{
+				return FTP_ERROR_CURL;
+			}
+			async_process_completed(async);
+		}
 
-		return result;
+		return (int)async->active_count;
 	}
 
-	int ftp_client_upload(ftp_client_t *client, const char *local_path, const char *remote_path)
+	int ftp_async_run(ftp_async_t *async)
 	{
-		if (!client || !client->curl || !local_path || !remote_path)
+		if (!async)
 		{
 			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		FILE *fp = fopen(local_path, "rb");
-		if (!fp)
+		int pending;
+		while ((pending = ftp_async_poll(async, 1000)) > 0)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot open local file: %s", local_path);
-			return FTP_ERROR_FILE_IO;
 		}
+		return pending < 0 ? pending : FTP_OK;
+	}
 
-		/* Use cross-platform 64-bit file size functions */
-		int64_t file_size;
-
-#ifdef _MSC_VER
-		/* Windows specific 64-bit functions */
-		if (_fseeki64(fp, 0, SEEK_END) != 0)
-		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
-			return FTP_ERROR_FILE_IO;
-		}
-		file_size = _ftelli64(fp);
-		if (_fseeki64(fp, 0, SEEK_SET) != 0)
+	int ftp_async_cancel(ftp_async_t *async, ftp_async_request_t *request)
+	{
+		if (!async || !request)
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
-			return FTP_ERROR_FILE_IO;
+			return FTP_ERROR_INVALID_PARAM;
 		}
-#else
-		/* POSIX standard 64-bit functions */
-		if (fseeko(fp, 0, SEEK_END) != 0)
+
+		snprintf(request->error, sizeof(request->error), "Request cancelled");
+		async_request_finish(async, request, FTP_ERROR_TRANSFER);
+		return FTP_OK;
+	}
+
+	const char *ftp_async_request_get_error(const ftp_async_request_t *request)
+	{
+		return request ? request->error : "Invalid request handle";
+	}
+
+	const char *ftp_async_request_get_data(const ftp_async_request_t *request, size_t *size)
+	{
+		if (!request)
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
-			return FTP_ERROR_FILE_IO;
+			return NULL;
 		}
-		off_t file_size_off = ftello(fp);
-		if (fseeko(fp, 0, SEEK_SET) != 0)
+		if (size)
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
-			return FTP_ERROR_FILE_IO;
+			*size = request->buffer.size;
 		}
-		file_size = (int64_t)file_size_off;
-#endif
+		return request->buffer.data;
+	}
 
-		if (file_size < 0)
+	int ftp_async_request_get_transfer_stats(const ftp_async_request_t *request, ftp_transfer_stats_t *stats)
+	{
+		if (!request || !stats)
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot determine file size");
-			return FTP_ERROR_FILE_IO;
+			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		curl_easy_reset(client->curl);
+		*stats = request->stats;
+		return FTP_OK;
+	}
 
-		char url[FTP_MAX_URL_LENGTH];
-		int result = build_ftp_url(client, remote_path, url, sizeof(url));
-		if (result != FTP_OK)
+	void ftp_async_destroy(ftp_async_t *async)
+	{
+		if (async)
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
-			return result;
+			while (async->active)
+			{
+				ftp_async_request_t *request = async->active;
+				async->active = request->next;
+				curl_multi_remove_handle(async->multi, request->curl);
+				if (request->kind == FTP_ASYNC_DOWNLOAD && request->fp)
+				{
+					fclose(request->fp);
+					request->fp = NULL;
+					remove(request->local_path);
+				}
+				async_request_free(async, request);
+			}
+
+			for (size_t i = 0; i < async->spare_count; i++)
+			{
+				curl_easy_cleanup(async->spare[i]);
+			}
+			free(async->spare);
+
+			if (async->multi)
+			{
+				curl_multi_cleanup(async->multi);
+			}
+			ftp_client_destroy(async->prototype);
+			free(async);
 		}
+	}
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
+	/* Parallel recursive directory walk */
 
-		curl_easy_setopt(client->curl, CURLOPT_UPLOAD, 1L);
-		curl_easy_setopt(client->curl, CURLOPT_READFUNCTION, read_file_callback);
-		curl_easy_setopt(client->curl, CURLOPT_READDATA, fp);
-		curl_easy_setopt(client->curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)file_size);
+	typedef struct
+	{
+		char *path;
+		int depth;
+	} ftp_walk_dir_t;
 
-		CURLcode res = curl_easy_perform(client->curl);
+	typedef struct
+	{
+		ftp_client_t *prototype; /* NULL when sessions come from the pool */
+		ftp_pool_t *pool;
+		ftp_walk_visitor_t visitor;
+		void *user_data;
+		int max_depth;
+
+		ftp_mutex_t mutex;
+		ftp_cond_t changed;
+		ftp_walk_dir_t *dirs; /* FIFO of directories to list, starting at head */
+		size_t head;
+		size_t count;
+		size_t capacity;
+		size_t busy;
+		int stop;
+		int result;
+		char error[512];
 
-		fclose(fp);
+		ftp_mutex_t visit_mutex; /* Serializes visitor calls */
+		int visitor_stopped;
+	} ftp_walk_t;
 
-		if (res != CURLE_OK)
+	typedef struct
+	{
+		ftp_walk_t *walk;
+		const char *dir_path;
+		int depth;
+	} ftp_walk_listing_t;
+
+	/* Record the first failure of the walk; caller holds the mutex */
+	static void walk_fail(ftp_walk_t *walk, int result, const char *dir_path, const char *message)
+	{
+		if (walk->result == FTP_OK)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Upload failed: %s", curl_easy_strerror(res));
-			return FTP_ERROR_TRANSFER;
+			walk->result = result;
+			snprintf(walk->error, sizeof(walk->error), "%s: %s", dir_path, message);
 		}
+	}
 
-		return FTP_OK;
+	/* Queue a directory; takes ownership of path. Caller holds the mutex. */
+	static int walk_push(ftp_walk_t *walk, char *path, int depth)
+	{
+		if (walk->head + walk->count == walk->capacity)
+		{
+			if (walk->head > 0)
+			{
+				memmove(walk->dirs, walk->dirs + walk->head, walk->count * sizeof(ftp_walk_dir_t));
+				walk->head = 0;
+			}
+			if (walk->count == walk->capacity)
+			{
+				size_t capacity = walk->capacity ? walk->capacity * 2 : 64;
+				ftp_walk_dir_t *dirs = (ftp_walk_dir_t *)realloc(walk->dirs, capacity * sizeof(ftp_walk_dir_t));
+				if (!dirs)
+				{
+					free(path);
+					return 0;
+				}
+				walk->dirs = dirs;
+				walk->capacity = capacity;
+			}
+		}
+
+		walk->dirs[walk->head + walk->count].path = path;
+		walk->dirs[walk->head + walk->count].depth = depth;
+		walk->count++;
+		ftp_cond_signal(&walk->changed);
+		return 1;
 	}
 
-	int ftp_client_download(ftp_client_t *client, const char *remote_path, const char *local_path)
+	static char *walk_join_path(const char *dir_path, const char *name)
 	{
-		if (!client || !client->curl || !local_path || !remote_path)
+		size_t dir_len = strlen(dir_path);
+		size_t name_len = strlen(name);
+		int slash = dir_len == 0 || dir_path[dir_len - 1] != '/';
+		char *path = (char *)malloc(dir_len + (size_t)slash + name_len + 1);
+		if (path)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			memcpy(path, dir_path, dir_len);
+			if (slash)
+			{
+				path[dir_len] = '/';
+			}
+			memcpy(path + dir_len + slash, name, name_len + 1);
 		}
+		return path;
+	}
 
-		FILE *fp = fopen(local_path, "wb");
-		if (!fp)
+	static int walk_entry_callback(void *user_data, const ftp_entry_t *entry)
+	{
+		ftp_walk_listing_t *listing = (ftp_walk_listing_t *)user_data;
+		ftp_walk_t *walk = listing->walk;
+
+		/* No visitor calls once the visitor asked to stop */
+		ftp_mutex_lock(&walk->visit_mutex);
+		int stop = walk->visitor_stopped;
+		if (!stop)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Cannot create local file: %s", local_path);
-			return FTP_ERROR_FILE_IO;
+			stop = walk->visitor_stopped = walk->visitor(walk->user_data, listing->dir_path, entry, listing->depth) != 0;
 		}
+		ftp_mutex_unlock(&walk->visit_mutex);
 
-		/* Reset curl handle to default state */
-		curl_easy_reset(client->curl);
+		int descend = !stop && entry->type == FTP_ENTRY_DIR &&
+					  (walk->max_depth < 0 || listing->depth < walk->max_depth);
+		char *child = descend ? walk_join_path(listing->dir_path, entry->name) : NULL;
 
-		char url[FTP_MAX_URL_LENGTH];
-		int result = build_ftp_url(client, remote_path, url, sizeof(url));
-		if (result != FTP_OK)
+		ftp_mutex_lock(&walk->mutex);
+		if (descend && (!child || !walk_push(walk, child, listing->depth + 1)))
 		{
-			fclose(fp);
-			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
-			return result;
+			walk_fail(walk, FTP_ERROR_MEMORY, listing->dir_path, "Failed to allocate memory for directory queue");
+			stop = 1;
+		}
+		if (stop)
+		{
+			walk->stop = 1;
+			ftp_cond_broadcast(&walk->changed);
 		}
+		stop = walk->stop;
+		ftp_mutex_unlock(&walk->mutex);
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_file_callback);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, fp);
+		return stop;
+	}
 
-		CURLcode res = curl_easy_perform(client->curl);
+	static FTP_THREAD_PROC(walk_worker)
+	{
+		ftp_walk_t *walk = (ftp_walk_t *)arg;
 
-		fclose(fp);
+		/* A worker without a session leaves the directories to the others */
+		ftp_client_t *client = walk->pool ? ftp_pool_checkout(walk->pool) : ftp_client_duplicate(walk->prototype);
+		if (!client)
+		{
+			FTP_THREAD_RETURN;
+		}
 
-		if (res != CURLE_OK)
+		ftp_mutex_lock(&walk->mutex);
+		for (;;)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Download failed: %s", curl_easy_strerror(res));
-			remove(local_path); /* Delete partial file */
+			/* The walk is over once nothing is queued and nobody can queue more */
+			while (!walk->stop && walk->count == 0 && walk->busy > 0)
+			{
+				ftp_cond_wait(&walk->changed, &walk->mutex);
+			}
+			if (walk->stop || walk->count == 0)
+			{
+				break;
+			}
 
-			if (res == CURLE_REMOTE_FILE_NOT_FOUND)
+			ftp_walk_dir_t dir = walk->dirs[walk->head++];
+			walk->count--;
+			walk->busy++;
+			ftp_mutex_unlock(&walk->mutex);
+
+			ftp_walk_listing_t listing;
+			listing.walk = walk;
+			listing.dir_path = dir.path;
+			listing.depth = dir.depth;
+			int result = ftp_client_list_dir_stream(client, dir.path, walk_entry_callback, &listing);
+
+			ftp_mutex_lock(&walk->mutex);
+			if (result != FTP_OK)
 			{
-				return FTP_ERROR_FILE_NOT_FOUND;
+				walk_fail(walk, result, dir.path, client->last_error);
 			}
-			return FTP_ERROR_TRANSFER;
+			free(dir.path);
+			walk->busy--;
+			ftp_cond_broadcast(&walk->changed);
 		}
+		ftp_cond_broadcast(&walk->changed);
+		ftp_mutex_unlock(&walk->mutex);
 
-		return FTP_OK;
+		if (walk->pool)
+		{
+			ftp_pool_checkin(walk->pool, client);
+		}
+		else
+		{
+			ftp_client_destroy(client);
+		}
+		FTP_THREAD_RETURN;
 	}
 
-	int ftp_client_list_dir(ftp_client_t *client, const char *remote_path, char **output)
+	void ftp_walk_init_options(ftp_walk_options_t *options)
 	{
-		if (!client || !client->curl || !output)
+		if (options)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			options->workers = 4;
+			options->max_depth = -1;
+			options->pool = NULL;
 		}
+	}
 
-		/* Reset curl handle to default state */
-		curl_easy_reset(client->curl);
-
-		char url[FTP_MAX_URL_LENGTH];
-		char dir_path[FTP_MAX_URL_LENGTH];
-
-		/* Ensure path ends with / to indicate it's a directory */
-		size_t len = strlen(remote_path);
-		if (len > 0 && remote_path[len - 1] != '/')
+	int ftp_walk(ftp_client_t *client, const char *root, ftp_walk_visitor_t visitor, void *user_data,
+				 const ftp_walk_options_t *options)
+	{
+		ftp_walk_options_t defaults;
+		if (!options)
 		{
-			snprintf(dir_path, sizeof(dir_path), "%s/", remote_path);
+			ftp_walk_init_options(&defaults);
+			options = &defaults;
 		}
-		else
+		if (!visitor || (!client && !options->pool))
 		{
-			/* Copy as-is if it already ends with / */
-			snprintf(dir_path, sizeof(dir_path), "%s", remote_path);
+			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		int result = build_ftp_url(client, dir_path, url, sizeof(url));
-		if (result != FTP_OK)
+		ftp_walk_t walk;
+		memset(&walk, 0, sizeof(walk));
+		walk.pool = options->pool;
+		walk.visitor = visitor;
+		walk.user_data = user_data;
+		walk.max_depth = options->max_depth;
+		walk.result = FTP_OK;
+
+		if (!walk.pool)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Directory path too long");
-			return result;
+			walk.prototype = ftp_client_duplicate(client);
+			if (!walk.prototype)
+			{
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to create worker client");
+				return FTP_ERROR_MEMORY;
+			}
+			/* Each worker lists many directories over its one connection */
+			walk.prototype->config.keep_session = 1;
 		}
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
-
-		ftp_memory_buffer_t buffer = {0};
-		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, &buffer);
-
-		CURLcode res = curl_easy_perform(client->curl);
+		ftp_mutex_init(&walk.mutex);
+		ftp_mutex_init(&walk.visit_mutex);
+		ftp_cond_init(&walk.changed);
 
-		if (res != CURLE_OK)
+		int workers = options->workers > 0 ? options->workers : 1;
+		if (walk.pool && (size_t)workers > walk.pool->options.max_sessions)
 		{
-			if (buffer.data)
+			workers = (int)walk.pool->options.max_sessions;
+		}
+		ftp_thread_t *threads = (ftp_thread_t *)calloc((size_t)workers, sizeof(ftp_thread_t));
+		char *root_path = threads ? strdup(root ? root : "/") : NULL;
+		if (!root_path || !walk_push(&walk, root_path, 0)) /* walk_push() frees the path if it fails */
+		{
+			if (client)
 			{
-				free(buffer.data);
+				snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for walk");
 			}
-			snprintf(client->last_error, sizeof(client->last_error), "Directory listing failed: %s",
-					 curl_easy_strerror(res));
-			return FTP_ERROR_TRANSFER;
+			ftp_cond_destroy(&walk.changed);
+			ftp_mutex_destroy(&walk.visit_mutex);
+			ftp_mutex_destroy(&walk.mutex);
+			free(threads);
+			free(walk.dirs);
+			ftp_client_destroy(walk.prototype);
+			return FTP_ERROR_MEMORY;
 		}
 
-		*output = buffer.data;
-		return FTP_OK;
-	}
+		int started = 0;
+		while (started < workers && ftp_thread_create(&threads[started], walk_worker, &walk) == 0)
+		{
+			started++;
+		}
+		if (started == 0)
+		{
+			/* Fall back to walking on the calling thread */
+			(void)walk_worker(&walk);
+		}
+		for (int i = 0; i < started; i++)
+		{
+			ftp_thread_join(threads[i]);
+		}
 
-	int ftp_client_mkdir(ftp_client_t *client, const char *remote_path)
-	{
-		if (!client || !client->curl || !remote_path)
+		/* Directories are left over if the walk was stopped or no worker got a session */
+		if (walk.count > 0 && !walk.stop)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			walk_fail(&walk, FTP_ERROR_CONNECTION, walk.dirs[walk.head].path,
+					  walk.pool ? "No session available from pool" : "Failed to create worker client");
+		}
+		for (size_t i = 0; i < walk.count; i++)
+		{
+			free(walk.dirs[walk.head + i].path);
 		}
 
-		size_t path_len = strlen(remote_path);
-		size_t cmd_len = 4 + path_len + 1;
-		if (cmd_len > 512)
+		if (walk.result != FTP_OK && client)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Path too long for MKD command");
-			return FTP_ERROR_INVALID_PARAM;
+			snprintf(client->last_error, sizeof(client->last_error), "%s", walk.error);
 		}
 
-		struct curl_slist *commands = NULL;
-		char cmd[512];
-		snprintf(cmd, sizeof(cmd), "MKD %s", remote_path);
-		commands = curl_slist_append(commands, cmd);
+		ftp_cond_destroy(&walk.changed);
+		ftp_mutex_destroy(&walk.visit_mutex);
+		ftp_mutex_destroy(&walk.mutex);
+		free(walk.dirs);
+		free(threads);
+		ftp_client_destroy(walk.prototype);
+		return walk.result;
+	}
 
-		int result = ftp_client_execute_simple_command(client, commands, "Create directory failed");
+	/* Directory sync */
 
-		curl_slist_free_all(commands);
-		return result;
-	}
+	typedef struct
+	{
+		char *path; /* Relative to the synced directory, '/'-separated */
+		int is_dir;
+		int64_t size;
+		int64_t mtime;
+	} ftp_sync_entry_t;
 
-	int ftp_client_rmdir(ftp_client_t *client, const char *remote_path)
+	typedef struct
 	{
-		if (!client || !client->curl || !remote_path)
+		ftp_sync_entry_t *items;
+		size_t count;
+		size_t capacity;
+	} ftp_sync_list_t;
+
+	typedef struct
+	{
+		ftp_sync_list_t *list;
+		size_t root_len;
+		int entries_seen;
+		int out_of_memory;
+	} ftp_sync_scan_t;
+
+	/* Takes ownership of path */
+	static int sync_list_add(ftp_sync_list_t *list, char *path, int is_dir, int64_t size, int64_t mtime)
+	{
+		if (!path)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			return 0;
 		}
-
-		size_t path_len = strlen(remote_path);
-		size_t cmd_len = 4 + path_len + 1;
-		if (cmd_len > 512)
+		if (list->count == list->capacity)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Path too long for RMD command");
-			return FTP_ERROR_INVALID_PARAM;
+			size_t capacity = list->capacity ? list->capacity * 2 : 256;
+			ftp_sync_entry_t *items = (ftp_sync_entry_t *)realloc(list->items, capacity * sizeof(ftp_sync_entry_t));
+			if (!items)
+			{
+				free(path);
+				return 0;
+			}
+			list->items = items;
+			list->capacity = capacity;
 		}
 
-		struct curl_slist *commands = NULL;
-		char cmd[512];
-		snprintf(cmd, sizeof(cmd), "RMD %s", remote_path);
-		commands = curl_slist_append(commands, cmd);
-
-		int result = ftp_client_execute_simple_command(client, commands, "Remove directory failed");
-
-		curl_slist_free_all(commands);
-		return result;
+		ftp_sync_entry_t *entry = &list->items[list->count++];
+		entry->path = path;
+		entry->is_dir = is_dir;
+		entry->size = size;
+		entry->mtime = mtime;
+		return 1;
 	}
 
-	int ftp_client_delete(ftp_client_t *client, const char *remote_path)
+	static void sync_list_free(ftp_sync_list_t *list)
 	{
-		if (!client || !client->curl || !remote_path)
+		for (size_t i = 0; i < list->count; i++)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			free(list->items[i].path);
 		}
+		free(list->items);
+	}
 
-		size_t path_len = strlen(remote_path);
-		size_t cmd_len = 5 + path_len + 1;
-		if (cmd_len > 512)
+	/* Path order with '/' sorting first, so a directory's contents directly follow it */
+	static int sync_path_compare(const char *a, const char *b)
+	{
+		while (*a && *a == *b)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Path too long for DELE command");
-			return FTP_ERROR_INVALID_PARAM;
+			a++;
+			b++;
 		}
+		int ca = *a == '/' ? 1 : (unsigned char)*a;
+		int cb = *b == '/' ? 1 : (unsigned char)*b;
+		return ca - cb;
+	}
 
-		struct curl_slist *commands = NULL;
-		char cmd[512];
-		snprintf(cmd, sizeof(cmd), "DELE %s", remote_path);
-		commands = curl_slist_append(commands, cmd);
+	static int sync_entry_compare(const void *a, const void *b)
+	{
+		return sync_path_compare(((const ftp_sync_entry_t *)a)->path, ((const ftp_sync_entry_t *)b)->path);
+	}
 
-		int result = ftp_client_execute_simple_command(client, commands, "Delete file failed");
+	static int sync_is_descendant(const char *path, const char *dir)
+	{
+		size_t len = strlen(dir);
+		return strncmp(path, dir, len) == 0 && path[len] == '/';
+	}
 
-		curl_slist_free_all(commands);
-		return result;
+	/* Join a base directory and a relative path; an empty relative path is the base itself */
+	static char *sync_join_path(const char *base, const char *relative)
+	{
+		return *relative ? walk_join_path(base, relative) : strdup(base);
 	}
 
-	int ftp_client_rename(ftp_client_t *client, const char *old_path, const char *new_path)
+	/* Scan a local directory tree into list; returns 0 on success, -1 if unreadable, -2 if out of memory, -3 if missing */
+	static int sync_scan_local(ftp_sync_list_t *list, const char *base, const char *relative)
 	{
-		if (!client || !client->curl || !old_path || !new_path)
+		char *dir_path = sync_join_path(base, relative);
+		if (!dir_path)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			return -2;
 		}
 
-		size_t old_len = strlen(old_path);
-		size_t new_len = strlen(new_path);
+		int result = 0;
+#ifdef _WIN32
+		char *pattern = walk_join_path(dir_path, "*");
+		WIN32_FIND_DATAA data;
+		HANDLE find = pattern ? FindFirstFileA(pattern, &data) : INVALID_HANDLE_VALUE;
+		free(pattern);
+		if (find == INVALID_HANDLE_VALUE)
+		{
+			DWORD error = GetLastError();
+			free(dir_path);
+			return error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND ? -3 : -1;
+		}
 
-		size_t cmd1_len = 5 + old_len + 1;
-		size_t cmd2_len = 5 + new_len + 1;
+		do
+		{
+			const char *name = data.cFileName;
+			if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			{
+				continue;
+			}
 
-		if (cmd1_len > 512 || cmd2_len > 512)
+			/* FILETIME counts 100 ns intervals since 1601-01-01 */
+			int64_t ticks = ((int64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+			int64_t mtime = (ticks - 116444736000000000LL) / 10000000LL;
+			int64_t size = ((int64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+			int is_dir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			if (is_dir && (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+			{
+				continue; /* Junctions and directory links may loop back to an ancestor */
+			}
+
+			char *child = *relative ? walk_join_path(relative, name) : strdup(name);
+			if (!sync_list_add(list, child, is_dir, is_dir ? 0 : size, mtime))
+			{
+				result = -2;
+				break;
+			}
+			if (is_dir)
+			{
+				result = sync_scan_local(list, base, list->items[list->count - 1].path);
+				if (result != 0)
+				{
+					break;
+				}
+			}
+		} while (FindNextFileA(find, &data));
+		FindClose(find);
+#else
+		DIR *dir = opendir(dir_path);
+		if (!dir)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Path too long for RNFR/RNTO command");
-			return FTP_ERROR_INVALID_PARAM;
+			int missing = errno == ENOENT;
+			free(dir_path);
+			return missing ? -3 : -1;
 		}
 
-		struct curl_slist *commands = NULL;
-		char cmd1[512], cmd2[512];
-		snprintf(cmd1, sizeof(cmd1), "RNFR %s", old_path);
-		snprintf(cmd2, sizeof(cmd2), "RNTO %s", new_path);
-		commands = curl_slist_append(commands, cmd1);
-		commands = curl_slist_append(commands, cmd2);
+		struct dirent *item;
+		while ((item = readdir(dir)) != NULL)
+		{
+			const char *name = item->d_name;
+			if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+			{
+				continue;
+			}
 
-		int result = ftp_client_execute_simple_command(client, commands, "Rename failed");
+			char *full_path = walk_join_path(dir_path, name);
+			/* Links to files are followed, links to directories are not: they may loop back to an ancestor */
+			struct stat info;
+			int found = full_path && lstat(full_path, &info) == 0;
+			if (found && S_ISLNK(info.st_mode))
+			{
+				found = stat(full_path, &info) == 0 && S_ISREG(info.st_mode);
+			}
+			free(full_path);
+			if (!found || (!S_ISDIR(info.st_mode) && !S_ISREG(info.st_mode)))
+			{
+				continue; /* Vanished, dangling or directory link, or special file */
+			}
 
-		curl_slist_free_all(commands);
-		return result;
+			int is_dir = S_ISDIR(info.st_mode);
+			char *child = *relative ? walk_join_path(relative, name) : strdup(name);
+			if (!sync_list_add(list, child, is_dir, is_dir ? 0 : (int64_t)info.st_size, (int64_t)info.st_mtime))
+			{
+				result = -2;
+				break;
+			}
+			if (is_dir)
+			{
+				result = sync_scan_local(list, base, list->items[list->count - 1].path);
+				if (result != 0)
+				{
+					break;
+				}
+			}
+		}
+		closedir(dir);
+#endif
+		free(dir_path);
+
+		/* Only the root itself may be missing; an unreadable subdirectory fails the scan */
+		return result == -3 && *relative ? -1 : result;
 	}
 
-	int ftp_client_get_filesize(ftp_client_t *client, const char *remote_path, int64_t *size)
+	static int sync_remote_visitor(void *user_data, const char *dir_path, const ftp_entry_t *entry, int depth)
 	{
-		if (!client || !client->curl || !remote_path || !size)
+		ftp_sync_scan_t *scan = (ftp_sync_scan_t *)user_data;
+		(void)depth;
+
+		scan->entries_seen = 1;
+		if (entry->type != FTP_ENTRY_FILE && entry->type != FTP_ENTRY_DIR)
 		{
-			return FTP_ERROR_INVALID_PARAM;
+			return 0;
 		}
 
-		/* Reset curl handle to default state */
-		curl_easy_reset(client->curl);
-
-		char url[FTP_MAX_URL_LENGTH];
-		int result = build_ftp_url(client, remote_path, url, sizeof(url));
-		if (result != FTP_OK)
+		const char *relative = dir_path + scan->root_len;
+		if (*relative == '/')
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Remote path too long");
-			return result;
+			relative++;
 		}
+		char *path = *relative ? walk_join_path(relative, entry->name) : strdup(entry->name);
+		int is_dir = entry->type == FTP_ENTRY_DIR;
+		if (!sync_list_add(scan->list, path, is_dir, is_dir || entry->size < 0 ? 0 : entry->size, entry->modify_time))
+		{
+			scan->out_of_memory = 1;
+			return 1;
+		}
+		return 0;
+	}
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
-
-		/* Use NOBODY to get file info without downloading content */
-		curl_easy_setopt(client->curl, CURLOPT_NOBODY, 1L);
-		curl_easy_setopt(client->curl, CURLOPT_FILETIME, 1L);
-		curl_easy_setopt(client->curl, CURLOPT_HEADER, 1L);
-
-		/* Provide write callback to discard any header data */
-		ftp_memory_buffer_t buffer = {0};
-		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, &buffer);
-
-		CURLcode res = curl_easy_perform(client->curl);
-
-		if (buffer.data)
+	/* Whether a file present on both sides needs to be transferred again */
+	static int sync_file_changed(const ftp_sync_entry_t *source, const ftp_sync_entry_t *target,
+								 const ftp_sync_options_t *options)
+	{
+		if (source->size != target->size)
 		{
-			free(buffer.data);
+			return 1;
 		}
+		return options->compare_mtime && source->mtime >= 0 && target->mtime >= 0 &&
+			   source->mtime > target->mtime + options->mtime_tolerance;
+	}
 
-		if (res != CURLE_OK)
+	static void sync_report(const ftp_sync_options_t *options, ftp_sync_action_t action, const char *path,
+							int64_t bytes, int result)
+	{
+		if (options->callback)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "Get file size failed: %s",
-					 curl_easy_strerror(res));
-			return FTP_ERROR_TRANSFER;
+			options->callback(options->user_data, action, *path ? path : ".", bytes, result);
 		}
+	}
 
-		/* Get file size from curl info */
-		curl_off_t filesize;
-		res = curl_easy_getinfo(client->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &filesize);
-		if (res == CURLE_OK && filesize >= 0)
+	/* Record a failed action; the first failure becomes the client's last error */
+	static void sync_fail(ftp_client_t *client, ftp_sync_stats_t *stats, const char *path, const char *message)
+	{
+		if (stats->failed++ == 0)
 		{
-			*size = (int64_t)filesize;
-			return FTP_OK;
+			snprintf(client->last_error, sizeof(client->last_error), "%s: %s", *path ? path : ".", message);
 		}
+	}
 
-		snprintf(client->last_error, sizeof(client->last_error), "Could not retrieve file size");
-		return FTP_ERROR_TRANSFER;
+	void ftp_sync_init_options(ftp_sync_options_t *options)
+	{
+		if (options)
+		{
+			options->workers = 4;
+			options->dry_run = 0;
+			options->delete_extra = 0;
+			options->compare_mtime = 1;
+			options->mtime_tolerance = 2;
+			options->callback = NULL;
+			options->user_data = NULL;
+		}
 	}
 
-	int ftp_client_execute_command(ftp_client_t *client, const char *command, char **response)
+	int ftp_sync(ftp_client_t *client, const char *local_dir, const char *remote_dir, ftp_sync_direction_t direction,
+				 const ftp_sync_options_t *options, ftp_sync_stats_t *stats)
 	{
-		if (!client || !client->curl || !command)
+		if (!client || !local_dir || !remote_dir || !*local_dir || !*remote_dir ||
+			(direction != FTP_SYNC_UPLOAD && direction != FTP_SYNC_DOWNLOAD))
 		{
 			return FTP_ERROR_INVALID_PARAM;
 		}
 
-		/* Reset curl handle to default state */
-		curl_easy_reset(client->curl);
-
-		char url[FTP_MAX_URL_LENGTH];
-		int result = build_ftp_url(client, "/", url, sizeof(url));
-		if (result != FTP_OK)
+		ftp_sync_options_t defaults;
+		if (!options)
 		{
-			snprintf(client->last_error, sizeof(client->last_error), "URL too long");
-			return result;
+			ftp_sync_init_options(&defaults);
+			options = &defaults;
 		}
+		ftp_sync_stats_t summary;
+		if (!stats)
+		{
+			stats = &summary;
+		}
+		memset(stats, 0, sizeof(*stats));
 
-		curl_easy_setopt(client->curl, CURLOPT_URL, url);
-		setup_curl_common(client);
-
-		struct curl_slist *commands = NULL;
-		commands = curl_slist_append(commands, command);
-		curl_easy_setopt(client->curl, CURLOPT_QUOTE, commands);
-
-		ftp_memory_buffer_t buffer = {0};
-		curl_easy_setopt(client->curl, CURLOPT_WRITEFUNCTION, write_memory_callback);
-		curl_easy_setopt(client->curl, CURLOPT_WRITEDATA, &buffer);
-
-		CURLcode res = curl_easy_perform(client->curl);
-
-		curl_slist_free_all(commands);
-
-		if (res != CURLE_OK)
+		/* The walk reports directories as the root path plus relative components */
+		size_t root_len = strlen(remote_dir);
+		while (root_len > 1 && remote_dir[root_len - 1] == '/')
 		{
-			if (buffer.data)
+			root_len--;
+		}
+		char *remote_root = (char *)malloc(root_len + 1);
+		if (!remote_root)
+		{
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for sync");
+			return FTP_ERROR_MEMORY;
+		}
+		memcpy(remote_root, remote_dir, root_len);
+		remote_root[root_len] = '\0';
+
+		ftp_sync_list_t local_list, remote_list;
+		memset(&local_list, 0, sizeof(local_list));
+		memset(&remote_list, 0, sizeof(remote_list));
+		int source_is_local = direction == FTP_SYNC_UPLOAD;
+		int create_root = 0;
+
+		/* A missing target directory is created; a missing source is an error */
+		int scan = sync_scan_local(&local_list, local_dir, "");
+		if (scan == -2 || scan == -1 || (scan == -3 && source_is_local))
+		{
+			snprintf(client->last_error, sizeof(client->last_error), scan == -2 ? "Failed to allocate memory for sync"
+																				 : "Failed to read local directory: %s",
+					 local_dir);
+			sync_list_free(&local_list);
+			free(remote_root);
+			return scan == -2 ? FTP_ERROR_MEMORY : FTP_ERROR_FILE_IO;
+		}
+		create_root = scan == -3;
+
+		ftp_sync_scan_t remote_scan;
+		memset(&remote_scan, 0, sizeof(remote_scan));
+		remote_scan.list = &remote_list;
+		remote_scan.root_len = strcmp(remote_root, "/") == 0 ? 0 : root_len;
+		ftp_walk_options_t walk_options;
+		ftp_walk_init_options(&walk_options);
+		walk_options.workers = options->workers > 0 ? options->workers : 1;
+		int result = ftp_walk(client, remote_root, sync_remote_visitor, &remote_scan, &walk_options);
+		if (result != FTP_OK)
+		{
+			/* A remote root that cannot be listed at all is treated as missing when uploading */
+			if (remote_scan.out_of_memory || !source_is_local || remote_scan.entries_seen)
 			{
-				free(buffer.data);
+				sync_list_free(&local_list);
+				sync_list_free(&remote_list);
+				free(remote_root);
+				return remote_scan.out_of_memory ? FTP_ERROR_MEMORY : result;
 			}
-			snprintf(client->last_error, sizeof(client->last_error), "Command execution failed: %s",
-					 curl_easy_strerror(res));
-			return FTP_ERROR_TRANSFER;
+			create_root = 1;
 		}
 
-		if (response)
+		ftp_sync_list_t *source = source_is_local ? &local_list : &remote_list;
+		ftp_sync_list_t *target = source_is_local ? &remote_list : &local_list;
+		qsort(source->items, source->count, sizeof(ftp_sync_entry_t), sync_entry_compare);
+		qsort(target->items, target->count, sizeof(ftp_sync_entry_t), sync_entry_compare);
+
+		/* Plan: indices into source for directories and files, into target for deletions */
+		size_t *mkdirs = (size_t *)malloc((source->count + 1) * sizeof(size_t));
+		size_t *copies = (size_t *)malloc((source->count + 1) * sizeof(size_t));
+		size_t *deletes = (size_t *)malloc((target->count + 1) * sizeof(size_t));
+		size_t mkdir_count = 0, copy_count = 0, delete_count = 0;
+		if (!mkdirs || !copies || !deletes)
 		{
-			*response = buffer.data;
+			snprintf(client->last_error, sizeof(client->last_error), "Failed to allocate memory for sync");
+			free(mkdirs);
+			free(copies);
+			free(deletes);
+			sync_list_free(&local_list);
+			sync_list_free(&remote_list);
+			free(remote_root);
+			return FTP_ERROR_MEMORY;
 		}
-		else if (buffer.data)
+
+		const char *conflict = NULL; /* Contents of a conflicting directory are left alone */
+		size_t s = 0, t = 0;
+		while (s < source->count || t < target->count)
 		{
-			free(buffer.data);
+			int order = s == source->count   ? 1
+						: t == target->count ? -1
+											 : sync_path_compare(source->items[s].path, target->items[t].path);
+			const char *path = order <= 0 ? source->items[s].path : target->items[t].path;
+			if (conflict && sync_is_descendant(path, conflict))
+			{
+				s += order <= 0;
+				t += order >= 0;
+				continue;
+			}
+
+			if (order < 0)
+			{
+				if (source->items[s].is_dir)
+				{
+					mkdirs[mkdir_count++] = s;
+				}
+				else
+				{
+					copies[copy_count++] = s;
+				}
+				s++;
+			}
+			else if (order > 0)
+			{
+				if (options->delete_extra)
+				{
+					deletes[delete_count++] = t;
+				}
+				t++;
+			}
+			else
+			{
+				const ftp_sync_entry_t *from = &source->items[s];
+				const ftp_sync_entry_t *to = &target->items[t];
+				if (from->is_dir != to->is_dir)
+				{
+					stats->conflicts++;
+					conflict = from->is_dir ? from->path : to->path;
+				}
+				else if (!from->is_dir)
+				{
+					stats->files_compared++;
+					if (sync_file_changed(from, to, options))
+					{
+						copies[copy_count++] = s;
+					}
+					else
+					{
+						stats->unchanged++;
+					}
+				}
+				s++;
+				t++;
+			}
 		}
 
-		return FTP_OK;
-	}
+		stats->directories_created = mkdir_count + (size_t)create_root;
+		stats->transfers = copy_count;
+		stats->deletions = delete_count;
+		ftp_sync_action_t mkdir_action = FTP_SYNC_ACTION_MKDIR;
+		ftp_sync_action_t copy_action = source_is_local ? FTP_SYNC_ACTION_UPLOAD : FTP_SYNC_ACTION_DOWNLOAD;
 
-	const char *ftp_client_get_error(ftp_client_t *client)
-	{
-		if (!client)
+		if (options->dry_run)
 		{
-			return "Invalid client handle";
+			if (create_root)
+			{
+				sync_report(options, mkdir_action, "", 0, FTP_OK);
+			}
+			for (size_t i = 0; i < mkdir_count; i++)
+			{
+				sync_report(options, mkdir_action, source->items[mkdirs[i]].path, 0, FTP_OK);
+			}
+			for (size_t i = 0; i < copy_count; i++)
+			{
+				const ftp_sync_entry_t *entry = &source->items[copies[i]];
+				stats->bytes += entry->size;
+				sync_report(options, copy_action, entry->path, entry->size, FTP_OK);
+			}
+			for (size_t i = delete_count; i-- > 0;)
+			{
+				const ftp_sync_entry_t *entry = &target->items[deletes[i]];
+				sync_report(options, entry->is_dir ? FTP_SYNC_ACTION_RMDIR : FTP_SYNC_ACTION_DELETE, entry->path, 0,
+							FTP_OK);
+			}
 		}
-		return client->last_error;
-	}
-
-	void ftp_client_destroy(ftp_client_t *client)
-	{
-		if (client)
+		else
 		{
-			if (client->curl)
+			/* Remote directory changes run one after another over a single login */
+			ftp_client_t *session = source_is_local && mkdir_count + delete_count + (size_t)create_root > 0
+										? ftp_client_duplicate(client)
+										: NULL;
+			if (session)
 			{
-				curl_easy_cleanup(client->curl);
+				session->config.keep_session = 1;
 			}
 
-			if (client->config.host)
+			/* Directories first, parents before children */
+			for (size_t i = 0; i <= mkdir_count; i++)
 			{
-				size_t host_len = strlen(client->config.host);
-				if (host_len > 0)
+				if (i == 0 && !create_root)
 				{
-					volatile char *p = (volatile char *)memset(client->config.host, 0, host_len);
-					(void)p;
+					continue;
 				}
-				free(client->config.host);
+				const char *path = i == 0 ? "" : source->items[mkdirs[i - 1]].path;
+				char *full_path = sync_join_path(source_is_local ? remote_root : local_dir, path);
+				int status = FTP_ERROR_MEMORY;
+				if (full_path && session)
+				{
+					status = ftp_client_mkdir(session, full_path);
+				}
+				else if (full_path && !source_is_local)
+				{
+					status = ftp_dir_create(full_path) == 0 ? FTP_OK : FTP_ERROR_FILE_IO;
+				}
+				free(full_path);
+				if (status != FTP_OK)
+				{
+					sync_fail(client, stats, path,
+							  session ? session->last_error
+							  : source_is_local ? "Failed to allocate memory for sync"
+												: "Failed to create local directory");
+				}
+				sync_report(options, mkdir_action, path, 0, status);
 			}
 
-			if (client->config.username)
+			/* Then the files, in parallel */
+			ftp_transfer_queue_t *queue = NULL;
+			long *job_ids = NULL;
+			if (copy_count > 0)
 			{
-				size_t username_len = strlen(client->config.username);
-				volatile char *p = (volatile char *)memset(client->config.username, 0, username_len);
-				(void)p;
-				free(client->config.username);
+				int workers = options->workers > 0 ? options->workers : 1;
+				if ((size_t)workers > copy_count)
+				{
+					workers = (int)copy_count;
+				}
+				queue = ftp_transfer_queue_create(client, workers);
+				job_ids = (long *)malloc(copy_count * sizeof(long));
+			}
+			for (size_t i = 0; i < copy_count && queue && job_ids; i++)
+			{
+				const char *path = source->items[copies[i]].path;
+				char *local_path = walk_join_path(local_dir, path);
+				char *remote_path = walk_join_path(remote_root, path);
+				job_ids[i] = local_path && remote_path
+								 ? ftp_transfer_queue_submit(queue, source_is_local ? FTP_JOB_UPLOAD : FTP_JOB_DOWNLOAD,
+															 local_path, remote_path)
+								 : FTP_ERROR_MEMORY;
+				free(local_path);
+				free(remote_path);
+			}
+			if (queue)
+			{
+				ftp_transfer_queue_wait(queue);
 			}
 
-			if (client->config.password)
+			for (size_t i = 0; i < copy_count; i++)
 			{
-				size_t password_len = strlen(client->config.password);
-				volatile char *p = (volatile char *)memset(client->config.password, 0, password_len);
-				(void)p;
-				free(client->config.password);
+				const ftp_sync_entry_t *entry = &source->items[copies[i]];
+				ftp_job_status_t status;
+				memset(&status, 0, sizeof(status));
+				status.result = FTP_ERROR_MEMORY;
+				snprintf(status.error, sizeof(status.error), "Failed to create transfer queue");
+				if (queue && job_ids && job_ids[i] >= 0)
+				{
+					ftp_transfer_queue_get_job_status(queue, job_ids[i], &status);
+				}
+
+				if (status.result == FTP_OK)
+				{
+					stats->bytes += status.bytes;
+					/* Keep the remote time so the next run sees the file as unchanged */
+					if (!source_is_local && entry->mtime >= 0)
+					{
+						char *local_path = walk_join_path(local_dir, entry->path);
+						if (local_path)
+						{
+							ftp_file_set_mtime(local_path, entry->mtime);
+						}
+						free(local_path);
+					}
+				}
+				else
+				{
+					sync_fail(client, stats, entry->path, status.error);
+				}
+				sync_report(options, copy_action, entry->path, status.result == FTP_OK ? status.bytes : 0,
+							status.result);
 			}
+			ftp_transfer_queue_destroy(queue);
+			free(job_ids);
 
-			free(client);
+			/* Deletions last, children before parents */
+			for (size_t i = delete_count; i-- > 0;)
+			{
+				const ftp_sync_entry_t *entry = &target->items[deletes[i]];
+				char *full_path = walk_join_path(source_is_local ? remote_root : local_dir, entry->path);
+				int status = FTP_ERROR_MEMORY;
+				if (full_path && session)
+				{
+					status = entry->is_dir ? ftp_client_rmdir(session, full_path) : ftp_client_delete(session, full_path);
+				}
+				else if (full_path && !source_is_local)
+				{
+					status = (entry->is_dir ? ftp_dir_remove(full_path) : remove(full_path)) == 0 ? FTP_OK
+																								  : FTP_ERROR_FILE_IO;
+				}
+				free(full_path);
+				if (status != FTP_OK)
+				{
+					sync_fail(client, stats, entry->path,
+							  session ? session->last_error
+							  : source_is_local ? "Failed to allocate memory for sync"
+												: "Failed to delete local file");
+				}
+				sync_report(options, entry->is_dir ? FTP_SYNC_ACTION_RMDIR : FTP_SYNC_ACTION_DELETE, entry->path, 0,
+							status);
+			}
+			ftp_client_destroy(session);
 		}
+
+		free(mkdirs);
+		free(copies);
+		free(deletes);
+		sync_list_free(&local_list);
+		sync_list_free(&remote_list);
+		free(remote_root);
+		return stats->failed > 0 ? FTP_ERROR_TRANSFER : FTP_OK;
 	}
 
 #endif /* FTP_CLIENT_IMPLEMENTATION */
@@ -1664,4 +10097,4 @@ extern "C"
  * SOFTWARE.
  *
  * ------------------------------------------------------------------------------
- */
\ No newline at end of file
+ */
\ No newline at end of file